@@ -182,6 +182,11 @@ void MQTT_issue_remote_task(tboard_t *t, remote_task_t *rtask)
     // copy message to send
     char message[MAX_MSG_LENGTH+1] = {0};
     strcpy(message, rtask->message);
+    if (DEBUG) { // task IDs only become uuid strings on the wire
+        char uuid[UUID4_LEN];
+        task_id_to_uuid(t, rtask->task_id, uuid);
+        tboard_log("MQTT_issue_remote_task: Issuing '%s' for task %s.\n", rtask->message, uuid);
+    }
 
 
     // simulate worker response by parsing message
@@ -213,10 +218,7 @@ void MQTT_issue_remote_task(tboard_t *t, remote_task_t *rtask)
     }
     // place response back into task board via remote_task_place() function call
 
-    remote_task_place(t, rtask, RTASK_RECV);
-    pthread_mutex_lock(&(t->pmutex));
-    pthread_cond_signal(&(t->pcond));
-    pthread_mutex_unlock(&(t->pmutex));
+    remote_task_place(t, rtask, RTASK_RECV); // rings doorbell of issuing executor
 
 }
 
@@ -241,15 +243,18 @@ void MQTT_recv(tboard_t *t)
         tok = strtok(NULL, ""); // can I do this to get the rest of the string?
         msg_t *msg = calloc(1, sizeof(msg_t)); // create message to send to task board
         msg->type = TASK_EXEC;
-        // copy data sent from controller
-        msg->user_data = calloc(strlen(orig_message)-5, sizeof(char)); // free'd when MQTT_Print_Message() terminates
-        // indicate that memory was allocated to be free'd later by task board
-        if(strlen(orig_message)-5 <= 0)
-            msg->ud_allocd = 1;
-        else
-            msg->ud_allocd = strlen(orig_message)-5;
-        // copy data from controller to be passed to task board
-        memcpy(msg->user_data, orig_message+6, strlen(orig_message)-6);
+        // copy data sent from controller, including terminator
+        size_t len = (strlen(orig_message) > 6) ? strlen(orig_message)-5 : 1;
+        if (len <= TASK_ARGS_INLINE) { // short message is copied into task_t, nothing to allocate
+            memcpy(msg->args, orig_message+6, len-1);
+            msg->args_size = len;
+        } else {
+            msg->user_data = calloc(len, sizeof(char)); // free'd when MQTT_Print_Message() terminates
+            // indicate that memory was allocated to be free'd later by task board
+            msg->ud_allocd = len;
+            // copy data from controller to be passed to task board
+            memcpy(msg->user_data, orig_message+6, len-1);
+        }
         // create task_t to pass to tboard containing pointer to local function task board will run
         msg->data = (task_t *)calloc(1, sizeof(task_t)); // free'd in MQTT_Thread()
         ((task_t *)(msg->data))->fn = TBOARD_FUNC(MQTT_Print_Message);
@@ -285,11 +290,12 @@ void MQTT_recv(tboard_t *t)
         double b = (b_str == NULL) ? 0 : atof(b_str);
         msg_t *msg = calloc(1, sizeof(msg_t));
         msg->type = TASK_EXEC;
-        msg->user_data = (struct arithmetic_s *)calloc(1, sizeof(struct arithmetic_s)); // free'd when MQTT_Do_Math() terminates
-        msg->ud_allocd = sizeof(struct arithmetic_s);
-        ((struct arithmetic_s *)(msg->user_data))->a = a;
-        ((struct arithmetic_s *)(msg->user_data))->b = b;
-        ((struct arithmetic_s *)(msg->user_data))->operator = op;
+        // operands are copied into task_t by msg_processor(), so nothing is allocated for them
+        struct arithmetic_s *args = (struct arithmetic_s *)(msg->args);
+        args->a = a;
+        args->b = b;
+        args->operator = op;
+        msg->args_size = sizeof(struct arithmetic_s);
 
         msg->data = (task_t *)calloc(1, sizeof(task_t)); // free'd in MQTT_Thread()
         ((task_t *)(msg->data))->fn = TBOARD_FUNC(MQTT_Do_Math);
@@ -1,11 +1,483 @@
 /* This controls the primary executor and secondary executor */
-
+#define _GNU_SOURCE // pthread_attr_setaffinity_np()
 
 #include "tboard.h"
 #include "queue/queue.h"
+#include "queue/deque.h"
+#include "queue/mpsc.h"
 #include "executor.h"
+#include "parker.h"
 #include <pthread.h>
+#include <sched.h> // sched_yield()
 #include <assert.h> // assert()
+#include <time.h> // nanosleep()
+
+// executor argument of the calling thread, NULL if the thread is not a task executor
+static _Thread_local exec_t *current_exec = NULL;
+
+exec_t *executor_current(tboard_t *t)
+{
+    if (current_exec != NULL && current_exec->tboard == t)
+        return current_exec;
+    return NULL;
+}
+
+void executor_yield(int kind, void *target, uint64_t wake_at)
+{
+    // we run on the thread of the executor that resumed us, which reads request once we yield
+    assert(current_exec != NULL && current_exec->running != NULL);
+    current_exec->request.kind = kind;
+    current_exec->request.target = target;
+    current_exec->request.wake_at = wake_at;
+    mco_yield(mco_running());
+}
+
+void executor_wake_primary(tboard_t *t)
+{
+    // pairs with fence in executor_park(): either pExec sees the new work, or we see it idle
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&(t->pidle), memory_order_relaxed) != 0)
+        parker_unpark(&(t->pparker));
+}
+
+void executor_wake(tboard_t *t, exec_t *exec)
+{
+    if (exec == NULL || exec->type == PRIMARY_EXEC) {
+        executor_wake_primary(t);
+        return;
+    }
+    // a retired sExecutor may never run TSeq again, and one that is not parked may be on its way
+    // out, so pExecutor makes sure the response is picked up
+    if (atomic_load(&(t->sretire[exec->num])) || !executor_wake_secondary(t, exec->num))
+        executor_wake_primary(t);
+}
+
+bool executor_wake_secondary(tboard_t *t, int num)
+{
+    atomic_thread_fence(memory_order_seq_cst); // as in executor_wake_primary()
+    if (atomic_load_explicit(&(t->sidle[num]), memory_order_relaxed) == 0)
+        return false;
+    parker_unpark(&(t->sparker[num]));
+    return true;
+}
+
+bool executor_inbox_reserve(tboard_t *t, int num, int n)
+{
+    // pairs with tboard_remove_secondary() lowering t->sqs before executor_retire() reads our
+    // count: either we see sExecutor num is retiring, or it waits for our push
+    atomic_fetch_add(&(t->sinbox_len[num]), n);
+    if (num < atomic_load(&(t->sqs)))
+        return true;
+    atomic_fetch_sub(&(t->sinbox_len[num]), n);
+    return false;
+}
+
+void executor_wake_idle(tboard_t *t, int skip)
+{
+    // pairs with fence in executor_park(): either the sleeper sees the new task, or we see it idle
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&(t->idle_count), memory_order_relaxed) == 0)
+        return;
+    for (int i=0; i<t->sqs; i++) {
+        if (i == skip || atomic_load(&(t->sidle[i])) == 0)
+            continue;
+        parker_unpark(&(t->sparker[i]));
+        return; // one thief is enough, it will wake the next if there is more to steal
+    }
+}
+
+void executor_print_stats(tboard_t *t, FILE *fptr)
+{
+    if (atomic_load(&(t->reg_cancelled)) > 0)
+        fprintf(fptr, "Registry: %ld cancelled tasks discarded\n", atomic_load(&(t->reg_cancelled)));
+    if (t->slice_budget > 0)
+        fprintf(fptr, "Watchdog: %ld slices overran budget of %.3f ms\n",
+            atomic_load(&(t->slice_overruns)), t->slice_budget / 1e6);
+    if (t->autoscale)
+        fprintf(fptr, "Autoscaler: added %ld sExecs, retired %ld sExecs, %d of %d-%d running\n",
+            t->scale_ups, t->scale_downs, atomic_load(&(t->sqs)), t->scale_min, t->scale_max);
+    for (int i=-1, smax=atomic_load_explicit(&(t->smax), memory_order_acquire); i<smax; i++) {
+        exec_t *exec = (i < 0) ? t->pexect : atomic_load_explicit(&(t->sexect[i]), memory_order_acquire);
+        if (exec == NULL) // task board was not started
+            continue;
+        fprintf(fptr, "Executor: %s %d entered idle spin %ld times, yield %ld times, parked %ld times\n",
+            (exec->type == PRIMARY_EXEC) ? "pExec" : "sExec", exec->num,
+            exec->idle_spins, exec->idle_yields, exec->idle_parks);
+        fprintf(fptr, "Executor: %s %d stole %ld tasks in %ld steals", (exec->type == PRIMARY_EXEC) ? "pExec" : "sExec",
+            exec->num, exec->steal_tasks, exec->steals);
+        if (exec->type == SECONDARY_EXEC)
+            fprintf(fptr, ", %ld of its tasks were stolen", atomic_load(&(t->sstolen[exec->num])));
+        fprintf(fptr, "\n");
+        if (t->slice_budget > 0)
+            fprintf(fptr, "Executor: %s %d ran %ld slices over budget\n",
+                (exec->type == PRIMARY_EXEC) ? "pExec" : "sExec", exec->num, exec->slice_overruns);
+        if (t->mlfq)
+            fprintf(fptr, "Executor: %s %d demoted %ld tasks, promoted %ld tasks, boosted %ld times\n",
+                (exec->type == PRIMARY_EXEC) ? "pExec" : "sExec", exec->num,
+                exec->mlfq_demotions, exec->mlfq_promotions, exec->mlfq_boosts);
+    }
+}
+
+static void executor_drain_pinbox(tboard_t *t)
+{
+    // only pExecutor consumes pinbox, so the consumer role is never contended
+    struct mpsc_node *node;
+    for (int i=0; i<INBOX_BATCH && (node = mpsc_pop(&(t->pinbox))) != NULL; i++) {
+        task_t *task = (task_t *)(node->data);
+        struct queue_entry *e = queue_init_node(&(task->entry), task);
+        if (task->type == PRIORITY_EXEC)
+            queue_insert_head(&(t->pqueue), e);
+        else
+            queue_insert_tail(&(t->pqueue), e);
+    }
+}
+
+static void executor_drain_inbox(tboard_t *t, int num)
+{
+    if (atomic_load_explicit(&(t->sinbox_len[num]), memory_order_relaxed) == 0)
+        return;
+    if (!mpsc_try_acquire(&(t->sinbox[num]))) // a sibling is taking from our inbox, try next time
+        return;
+    // demoted tasks keep their level, whether they were borrowed, asleep or waiting on a response
+    struct mpsc_node *node;
+    int n = 0;
+    while (n < INBOX_BATCH && (node = mpsc_pop(&(t->sinbox[num]))) != NULL) {
+        mlfq_place(t, num, node->data); // node is embedded in task, nothing to free
+        n++;
+    }
+    mpsc_release(&(t->sinbox[num]));
+    atomic_fetch_sub_explicit(&(t->sinbox_len[num]), n, memory_order_relaxed);
+}
+
+static task_t *executor_steal(tboard_t *t, exec_t *self, int *victim)
+{
+    // try siblings in rotating order, each scan starting one further than the last, so no victim
+    // is always robbed first. pExec borrows a single task and returns it to its queue when it
+    // yields. sExec keeps what it steals, so it takes half of the victim's tasks at once, running
+    // the first and pushing the rest to its own deque. Nothing is locked, deque_steal() and the
+    // inbox consumer role both fail instead of waiting
+    int sqs = t->sqs;
+    if (sqs == 0)
+        return NULL;
+    int num = (self->type == SECONDARY_EXEC) ? self->num : -1;
+    int start = self->steal_next % sqs;
+    self->steal_next = start + 1;
+    for (int k=0; k<sqs; k++) {
+        int i = (start + k) % sqs;
+        if (i == num)
+            continue;
+        int n = 0;
+        task_t *task = deque_steal(&(t->sdeque[i]));
+        if (task != NULL) {
+            n = 1;
+            // one taken, take half of the rest, which with the first is half of what victim had
+            long batch = (num >= 0) ? deque_size(&(t->sdeque[i])) / 2 : 0;
+            for (; batch > 0 && n < STEAL_BATCH; batch--, n++) {
+                task_t *extra = deque_steal(&(t->sdeque[i]));
+                if (extra == NULL)
+                    break;
+                mlfq_place(t, num, extra);
+            }
+        } else if (atomic_load_explicit(&(t->sinbox_len[i]), memory_order_relaxed) > 0
+                   && mpsc_try_acquire(&(t->sinbox[i]))) {
+            // victim is busy and has not drained its inbox, take directly from there
+            long batch = (num >= 0) ? (atomic_load_explicit(&(t->sinbox_len[i]), memory_order_relaxed) + 1) / 2 : 1;
+            struct mpsc_node *node;
+            while (n < batch && n < STEAL_BATCH && (node = mpsc_pop(&(t->sinbox[i]))) != NULL) {
+                if (n++ == 0)
+                    task = (task_t *)(node->data);
+                else
+                    mlfq_place(t, num, node->data); // node is embedded in task
+            }
+            mpsc_release(&(t->sinbox[i]));
+            if (n > 0)
+                atomic_fetch_sub_explicit(&(t->sinbox_len[i]), n, memory_order_relaxed);
+        }
+        if (task != NULL) {
+            *victim = i;
+            atomic_fetch_add_explicit(&(t->sstolen[i]), n, memory_order_relaxed);
+            self->steals++;
+            self->steal_tasks += n;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static bool executor_has_work(tboard_t *t, int type, int num)
+{
+    // pending remote task responses need TSeq to run, which any executor does
+    if (atomic_load(&(t->msg_pending)) > 0)
+        return true;
+    if (type == PRIMARY_EXEC) {
+        if (!mpsc_empty(&(t->pinbox)) || queue_peek_front(&(t->pqueue)) != NULL || scheduler_wait(t) == 0
+            || timer_wait(t) == 0)
+            return true;
+    } else if (atomic_load(&(t->sinbox_len[num])) > 0 || mlfq_has_work(t, num) || atomic_load(&(t->sretire[num]))) {
+        return true;
+    }
+    for (int i=0; i<t->sqs; i++) {
+        if (deque_size(&(t->sdeque[i])) > 0 || atomic_load(&(t->sinbox_len[i])) > 0)
+            return true;
+    }
+    return false;
+}
+
+static uint64_t *executor_affinity(tboard_t *t, exec_t *exec)
+{
+    // CPU mask of executor, NULL if it is not pinned
+    uint64_t *mask = (exec->type == PRIMARY_EXEC) ? t->paffinity : t->saffinity[exec->num];
+    for (int w=0; w<AFFINITY_WORDS; w++) {
+        if (mask[w] != 0)
+            return mask;
+    }
+    return NULL;
+}
+
+void executor_spawn(tboard_t *t, pthread_t *thread, exec_t *exec)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+#ifdef __linux__
+    uint64_t *mask = executor_affinity(t, exec);
+    if (mask != NULL) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu=0; cpu<MAX_CPUS && cpu<CPU_SETSIZE; cpu++) {
+            if (mask[cpu / 64] & (1ULL << (cpu % 64)))
+                CPU_SET(cpu, &cpus);
+        }
+        if (pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpus) != 0)
+            tboard_err("executor_spawn: Unable to pin %s %d, running unpinned.\n",
+                (exec->type == PRIMARY_EXEC) ? "pExec" : "sExec", exec->num);
+    }
+#endif
+    if (pthread_create(thread, &attr, executor, exec) != 0 && executor_affinity(t, exec) != NULL) {
+        // CPUs may not be available to us, e.g. restricted by cgroup. Better run anywhere than not at all
+        tboard_err("executor_spawn: Unable to start %s %d on its CPUs, running unpinned.\n",
+            (exec->type == PRIMARY_EXEC) ? "pExec" : "sExec", exec->num);
+        pthread_create(thread, NULL, executor, exec);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+static void executor_localize(tboard_t *t, exec_t *exec)
+{
+    // we are running on our own CPUs now, so memory we allocate and touch is local to them
+    if (exec->type == SECONDARY_EXEC && !exec->localized) // relocating again would only pile up copies
+        deque_relocate(&(t->sdeque[exec->num]));
+    exec->localized = true;
+    pool_cache_prefill(&(t->task_pool), &(exec->task_cache), POOL_CACHE_SIZE);
+    // only largest class is prefilled, history has not told us which ones we need yet
+    pool_cache_prefill(&(t->stack_pool[STACK_CLASSES-1]), &(exec->stack_cache[STACK_CLASSES-1]), STACK_CACHE_SIZE);
+}
+
+static long executor_primary_wait(tboard_t *t)
+{
+    // nanoseconds pExecutor may park for, -1 if it may park until unparked
+    long sched = scheduler_wait(t), timer = timer_wait(t);
+    if (sched >= 0)
+        sched *= 1000000L;
+    if (sched < 0 || (timer >= 0 && timer < sched))
+        return timer;
+    return sched;
+}
+
+static void executor_park(tboard_t *t, int type, int num)
+{
+    // announce that we are about to park before the final check for work. Anyone making work
+    // available afterwards sees us idle and unparks us, and an unpark arriving before we park
+    // leaves a permit, so parker_park() returns right away. tboard_kill() sets t->shutdown
+    // before unparking every executor
+    bool primary = (type == PRIMARY_EXEC);
+    atomic_int *idle = primary ? &(t->pidle) : &(t->sidle[num]);
+    atomic_store(idle, 1);
+    if (!primary)
+        atomic_fetch_add(&(t->idle_count), 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (t->shutdown == 0 && !executor_has_work(t, type, num)) {
+        // pExecutor must be back by the time the next scheduled task is due or timer expires
+        long wait = primary ? executor_primary_wait(t) : -1;
+        struct timespec timeout = { .tv_sec = wait / 1000000000L, .tv_nsec = wait % 1000000000L };
+        if (wait != 0) // a timer may have become due since we checked for work
+            parker_park(primary ? &(t->pparker) : &(t->sparker[num]), (wait > 0) ? &timeout : NULL);
+    }
+    if (!primary)
+        atomic_fetch_sub(&(t->idle_count), 1);
+    atomic_store(idle, 0);
+}
+
+static void executor_idle(tboard_t *t, exec_t *exec, int *idle)
+{
+    // spin-block phase, then yield phase, then sleep-wake phase. *idle counts iterations
+    // without a task and is reset by the caller once a task is found
+    int n = (*idle)++;
+    if (n < t->idle_spin) {
+        if (n == 0)
+            exec->idle_spins++;
+        cpu_relax();
+    } else if (n < t->idle_spin + t->idle_yield) {
+        if (n == t->idle_spin)
+            exec->idle_yields++;
+        sched_yield();
+    } else {
+        exec->idle_parks++;
+        executor_park(t, exec->type, exec->num);
+        *idle = 0;
+    }
+}
+
+static void executor_reinsert(tboard_t *t, int type, int num, int victim, task_t *task)
+{
+    if (task->scheduled) { // keeps its place in deadline schedule
+        scheduler_place(t, task);
+    } else if (type == PRIMARY_EXEC && victim < 0) { // task came from primary ready queue
+        struct queue_entry *e = queue_init_node(&(task->entry), task);
+        if (REINSERT_PRIORITY_AT_HEAD == 1 && task->type == PRIORITY_EXEC)
+            queue_insert_head(&(t->pqueue), e); // if specified put priority at head
+        else
+            queue_insert_tail(&(t->pqueue), e); // put task in tail of primary queue
+    } else if (type == PRIMARY_EXEC) { // secondary task borrowed by pExec, return it to its queue
+        if (executor_inbox_reserve(t, victim, 1)) {
+            mpsc_push(&(t->sinbox[victim]), &(task->inject), task);
+            executor_wake_secondary(t, victim); // we wish to wake secondary executor if asleep
+        } else { // victim retired meanwhile
+            task_place(t, task);
+        }
+    } else { // sExec owns its deque, stolen tasks migrate to the thief
+        mlfq_place(t, num, task); // its deque, unless task was demoted
+        if (deque_size(&(t->sdeque[num])) > 1)
+            executor_wake_idle(t, num);
+    }
+}
+
+void executor_retire(tboard_t *t, int num)
+{
+    // placement no longer selects us, but pushes counted before that may still be in progress
+    while (atomic_load(&(t->sinbox_len[num])) > 0) {
+        int n = 0;
+        if (mpsc_try_acquire(&(t->sinbox[num]))) { // a thief may hold it for a moment
+            struct mpsc_node *node;
+            while ((node = mpsc_pop(&(t->sinbox[num]))) != NULL) {
+                mlfq_place(t, num, node->data);
+                n++;
+            }
+            mpsc_release(&(t->sinbox[num]));
+            atomic_fetch_sub(&(t->sinbox_len[num]), n);
+        }
+        if (n == 0)
+            cpu_relax();
+    }
+    // hand everything we hold to the remaining executors, oldest first. Thieves may take some meanwhile
+    task_t *task;
+    while ((task = deque_steal(&(t->sdeque[num]))) != NULL)
+        task_place(t, task);
+    while ((task = mlfq_next(t, num)) != NULL) // keep their level at the sExecutor they move to
+        task_place(t, task);
+}
+
+void *executor_autoscale(void *arg)
+{
+    tboard_t *t = (tboard_t *)arg;
+    struct timespec interval = { .tv_sec = AUTOSCALE_INTERVAL / 1000, .tv_nsec = (AUTOSCALE_INTERVAL % 1000) * 1000000L };
+    int quiet = 0; // consecutive intervals with an idle sExecutor and nothing queued
+
+    while (t->shutdown == 0) {
+        nanosleep(&interval, NULL);
+        int sqs = t->sqs;
+        if (sqs < t->scale_min) {
+            if (tboard_add_secondary(t) >= 0)
+                t->scale_ups++;
+            continue;
+        } else if (sqs > t->scale_max) {
+            if (tboard_remove_secondary(t))
+                t->scale_downs++;
+            continue;
+        }
+        long queued = 0;
+        for (int i=0; i<sqs; i++)
+            queued += deque_size(&(t->sdeque[i])) + atomic_load_explicit(&(t->sinbox_len[i]), memory_order_relaxed);
+        int idle = atomic_load(&(t->idle_count));
+
+        if (idle == 0 && queued > (long)AUTOSCALE_QUEUE_DEPTH * sqs && sqs < t->scale_max) {
+            // every sExecutor is busy and work piles up
+            quiet = 0;
+            if (tboard_add_secondary(t) >= 0)
+                t->scale_ups++;
+        } else if (idle > 0 && queued == 0 && sqs > t->scale_min) {
+            // quiet long enough, retire one per interval until load picks up again
+            if (++quiet >= AUTOSCALE_QUIET_PERIODS) {
+                if (tboard_remove_secondary(t))
+                    t->scale_downs++;
+            }
+        } else {
+            quiet = 0;
+        }
+    }
+    return NULL;
+}
+
+static void executor_watchdog_check(tboard_t *t, exec_t *exec, uint64_t now)
+{
+    uint64_t start = atomic_load(&(exec->slice_start));
+    if (start == 0 || now < start + t->slice_budget)
+        return;
+    history_t *hist = atomic_load(&(exec->slice_hist));
+    if (atomic_load(&(exec->slice_start)) != start || hist == NULL)
+        return; // slice ended while we looked, @hist may belong to the next one
+    bool flagged = (exec->slice_flagged != start);
+    history_record_overrun(t, hist, now - start, flagged);
+    if (!flagged) // still running, history now holds how long so far
+        return;
+    exec->slice_flagged = start;
+    exec->slice_overruns++;
+    atomic_fetch_add_explicit(&(t->slice_overruns), 1, memory_order_relaxed);
+    tboard_err("watchdog: Task '%s' has run on %s %d for %.3f ms without yielding (budget %.3f ms).\n",
+        hist->fn_name, (exec->type == PRIMARY_EXEC) ? "pExec" : "sExec", exec->num,
+        (now - start) / 1e6, t->slice_budget / 1e6);
+    if (!t->slice_quarantine || exec->type != SECONDARY_EXEC)
+        return;
+    atomic_store(&(t->squarantine[exec->num]), true);
+    // pairs with executor_slice_end(): either it sees the quarantine and lifts it, or we see the slice ended
+    if (atomic_load(&(exec->slice_start)) != start)
+        atomic_store(&(t->squarantine[exec->num]), false);
+    else
+        executor_wake_idle(t, exec->num); // let a sibling steal what is queued behind the task
+}
+
+void *executor_watchdog(void *arg)
+{
+    tboard_t *t = (tboard_t *)arg;
+    // check a few times per budget, so a slice is flagged at most a quarter budget late
+    uint64_t period = t->slice_budget / 4;
+    if (period < TIMER_RESOLUTION)
+        period = TIMER_RESOLUTION;
+    struct timespec interval = { .tv_sec = period / 1000000000ULL, .tv_nsec = period % 1000000000ULL };
+
+    while (t->shutdown == 0) {
+        nanosleep(&interval, NULL);
+        uint64_t now = timer_now();
+        for (int i=-1, smax=atomic_load_explicit(&(t->smax), memory_order_acquire); i<smax; i++) {
+            exec_t *exec = (i < 0) ? t->pexect : atomic_load_explicit(&(t->sexect[i]), memory_order_acquire);
+            if (exec != NULL)
+                executor_watchdog_check(t, exec, now);
+        }
+    }
+    return NULL;
+}
+
+static void executor_slice_begin(exec_t *exec, task_t *task)
+{
+    atomic_store_explicit(&(exec->slice_hist), task->hist, memory_order_relaxed);
+    atomic_store_explicit(&(exec->slice_start), timer_now(), memory_order_release);
+}
+
+static void executor_slice_end(tboard_t *t, exec_t *exec)
+{
+    atomic_store(&(exec->slice_start), 0);
+    if (exec->type == SECONDARY_EXEC && atomic_load(&(t->squarantine[exec->num])))
+        atomic_store(&(t->squarantine[exec->num]), false); // task yielded or terminated, lift quarantine
+}
 
 
 void *executor(void *arg)
@@ -17,6 +489,13 @@ void *executor(void *arg)
     int type = args.type;
     int num = args.num;
     long start_time, end_time;
+    int idle = 0; // consecutive iterations without a task, drives idle policy
+
+    current_exec = (exec_t *)arg; // freed in tboard_destroy() after we are joined
+    if (type == SECONDARY_EXEC) // start stealing after ourselves, so thieves spread across victims
+        current_exec->steal_next = num + 1;
+    if (executor_affinity(tboard, current_exec) != NULL)
+        executor_localize(tboard, current_exec);
 
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL); // disable premature cancellation by tboard_kill()
                                                           // to ensure always graceful terminations
@@ -26,121 +505,151 @@ void *executor(void *arg)
         pthread_testcancel();
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
 
+        // sExecutor told to retire by tboard_remove_secondary(), between tasks so it holds none
+        if (type == SECONDARY_EXEC && atomic_load_explicit(&(tboard->sretire[num]), memory_order_acquire)) {
+            executor_retire(tboard, num);
+            break;
+        }
+
         // run sequencer
         task_sequencer(tboard); 
+        // return sleeping tasks whose time has come to ready queues
+        timer_advance(tboard);
 
         //// define variables needed for each iteration
-        struct queue_entry *next = NULL; // queue entry of ready queue
-        // the following variables are to keep track of which secondary queue (if any)
-        // task is taken out of. This is important to track for pExec after taking a task
-        // out of a secondary queue when primary queue is empty
-        struct queue *q = NULL; // queue entry to reinsert task into after yielding
-        pthread_mutex_t *mutex = NULL; // mutex to lock for previous queue
-        pthread_cond_t *cond = NULL; // condition variable to signal after insertion
+        task_t *task = NULL; // task to run
+        // secondary queue task was stolen from. This is important to track for pExec, which
+        // returns tasks taken out of a secondary queue when primary queue is empty
+        int victim = -1;
 
 
         ////// Fetch next process to run ////////
         if (type == PRIMARY_EXEC) { // we're in pExec
-            // check if any primary tasks are waiting in primary ready queue
-            pthread_mutex_lock(&(tboard->pmutex));
-            mutex = &(tboard->pmutex);
-            cond = &(tboard->pcond);
-            q = &(tboard->pqueue);
-            next = queue_peek_front(q);
-            if (next) {  // we found a primary task so we pop it
-                queue_pop_head(q);
-            } else { // no primary tasks are ready, try to pull a secondary task from any
-                     // secondary queue to execute
-                for(int i=0; i<tboard->sqs; i++){
-                    // lock appropriate mutex
-                    pthread_mutex_lock(&(tboard->smutex[i]));
-                    q = &(tboard->squeue[i]);
-                    next = queue_peek_front(q);
-                    if(next){ // found a task to run, pop it and stop searching
-                        queue_pop_head(q);
-                        mutex = &(tboard->smutex[i]);
-                        cond = &(tboard->scond[i]);
-                        pthread_mutex_unlock(&(tboard->smutex[i]));
-                        break;
-                    }
-                    pthread_mutex_unlock(&(tboard->smutex[i]));
-                }
+            // move primary tasks placed by other threads into primary ready queue, then
+            // check if any primary tasks are waiting in it. Only we access it, so no locking.
+            // Scheduled tasks that are due take precedence, in order of earliest deadline
+            executor_drain_pinbox(tboard);
+            task = scheduler_next(tboard);
+            struct queue_entry *next = (task == NULL) ? queue_pop_head(&(tboard->pqueue)) : NULL;
+            if (next) // we found a primary task
+                task = (task_t *)(next->data);
+            else if (task == NULL) // no primary tasks are ready, try to steal a secondary task from any
+                                   // secondary queue to execute
+                task = executor_steal(tboard, (exec_t *)arg, &victim);
+        } else { // we're in sExec, move tasks placed by other threads into our deque
+            executor_drain_inbox(tboard, num);
+            mlfq_age(tboard, num, (exec_t *)arg);
+            // take the oldest task so yielded tasks pushed to the bottom run round robin
+            task = deque_steal(&(tboard->sdeque[num]));
+            if (task == NULL) { // nothing of our own, steal from a busy sibling
+                task = executor_steal(tboard, (exec_t *)arg, &victim);
+                if (task != NULL && deque_size(&(tboard->sdeque[victim])) > 1)
+                    executor_wake_idle(tboard, num); // victim still has surplus, wake another thief
             }
-            pthread_mutex_unlock(&(tboard->pmutex));
-        } else { // we're in sExec, check if any task exists
-            pthread_mutex_lock(&(tboard->smutex[num]));
-            mutex = &(tboard->smutex[num]);
-            cond = &(tboard->scond[num]);
-            q = &(tboard->squeue[num]);
-            next = queue_peek_front(q);
-            if(next) queue_pop_head(q);
-            pthread_mutex_unlock(&(tboard->smutex[num]));
+            if (task == NULL) // only demoted tasks are left
+                task = mlfq_next(tboard, num);
         }
         
-        if (next) { // TExec found a task to run
+        if (task) { // TExec found a task to run
+            idle = 0;
+            if (atomic_load_explicit(&(task->cancelled), memory_order_acquire)) {
+                // cancelled while it waited, release it instead of resuming it
+                registry_discard(tboard, task);
+                continue;
+            }
 
-            ////////// Get queue data, and swap context to function until task yields ///////////
-            task_t *task = ((task_t *)(next->data));
+            ////////// Swap context to function until task yields ///////////
             task->status = TASK_RUNNING; // update status incase first run
 
+            if (tboard->slice_budget > 0) // let watchdog see how long this slice runs
+                executor_slice_begin((exec_t *)arg, task);
             start_time = clock(); // record start time
+            ((exec_t *)arg)->running = task; // task_join_all() looks itself up here
             mco_resume(task->ctx); // swap context to task
+            ((exec_t *)arg)->running = NULL;
+            // take request task yielded with, if any, so next task starts with a clean one
+            yield_request_t request = ((exec_t *)arg)->request;
+            ((exec_t *)arg)->request.kind = YIELD_NONE;
             end_time = clock(); // record end time
+            if (tboard->slice_budget > 0)
+                executor_slice_end(tboard, (exec_t *)arg);
 
             // record task iteration time in task_t
             task->cpu_time += (end_time - start_time);
 
+            // task came close to overrunning the stack size class history picked for it
+            if (task->stack_guard && !task_stack_check(task->ctx)) {
+                tboard_err("executor: Task '%s' reached guard of its %zu byte stack, its function gets %d bytes from now on.\n",
+                    task->fn.fn_name, task->ctx->stack_size, STACK_SIZE);
+                history_pin_stack(tboard, task->hist);
+                task->stack_guard = false;
+            }
+
             // check status of task
             int status = mco_status(task->ctx);
             if (status == MCO_SUSPENDED) { // task yielded
                 task->yields++; // increment # yields of specific task
                 task->hist->yields++; // increment total # yields in history hash table
-                struct queue_entry *e = NULL;
+                // may change feedback queue level. Not for slices run by pExec, which borrowed
+                // task and has no feedback queues of its own to charge
+                if (task->type == SECONDARY_EXEC && type == SECONDARY_EXEC)
+                    mlfq_feedback(tboard, task, end_time - start_time, (exec_t *)arg);
+                bool reinsert = false;
 
                 // check if task yielded with special instruction
-                if (mco_get_bytes_stored(task->ctx) == sizeof(task_t)) {
-                    // indicative of blocking local task creation, so we must retrieve it
-                    task_t *subtask = calloc(1, sizeof(task_t)); // freed on termination
-                    assert(mco_pop(task->ctx, subtask, sizeof(task_t)) == MCO_SUCCESS);
+                if (request.kind == YIELD_JOIN) {
+                    // task_join_all() waits for children, last one to terminate places task back
+                    reinsert = future_park(task, (task_join_t *)request.target);
+                } else if (request.kind == YIELD_CHILD) {
+                    // blocking local task creation, child runs in place of task
+                    task_t *subtask = (task_t *)request.target; // returned to pool on termination
                     // save issuing task_t object in subtask task_t object
                     subtask->parent = task;
                     // place task in appropriate queue corresponding to subtask->type
                     task_place(tboard, subtask); 
-                } else if (mco_get_bytes_stored(task->ctx) == sizeof(remote_task_t)) {
-                    // indicative of remote task creation, so we must retrieve it
-                    remote_task_t *rtask = calloc(1, sizeof(remote_task_t)); // freed on retrieval
-                    assert(mco_pop(task->ctx, rtask, sizeof(remote_task_t)) == MCO_SUCCESS);
+                } else if (request.kind == YIELD_REMOTE) {
+                    // remote task creation, returned to pool once response is handled
+                    remote_task_t *rtask = (remote_task_t *)request.target;
                     // task issuing task_t object in remote task object
                     rtask->calling_task = task;
+                    rtask->issuer = (exec_t *)arg; // doorbell to ring on response
+                    // blocking child tasks have no ID, so correlate with the task they stand in for
+                    for (task_t *issuer = task; issuer != NULL && rtask->task_id == 0; issuer = issuer->parent)
+                        rtask->task_id = issuer->id;
+
                     // if task is not blocking we wish to reinsert issuing task back into ready queue
-                    if (!rtask->blocking) 
-                        e = queue_new_node(task);
+                    reinsert = !rtask->blocking;
                     // place remote task into appropriate message queue
                     remote_task_place(tboard, rtask, RTASK_SEND);
                     
-                } else { // just a normal yield, so we create node to reinsert task into queue
-                    e = queue_new_node(task);
+                } else if (request.kind == YIELD_SLEEP) {
+                    // task_sleep(), task waits in timer wheel instead of a ready queue
+                    reinsert = !timer_add(tboard, task, request.wake_at);
+                } else { // just a normal yield, so we reinsert task into queue
+                    reinsert = true;
                 }
 
-                if (e != NULL){
-                    // reinsert task into queue it was taken out of
-                    pthread_mutex_lock(mutex); // lock appropriate mutex
-                    if (REINSERT_PRIORITY_AT_HEAD == 1 && task->type == PRIORITY_EXEC)
-                        queue_insert_head(q, e); // if specified put priority at head
-                    else
-                        queue_insert_tail(q, e); // put task in tail of appropriate queue
-                    if(type == PRIMARY_EXEC) pthread_cond_signal(cond); // we wish to wake secondary executors if they are asleep
-                    pthread_mutex_unlock(mutex);
-                }
+                if (reinsert) // reinsert task into queue it was taken out of
+                    executor_reinsert(tboard, type, num, victim, task);
             } else if (status == MCO_DEAD) { // task has terminated
                 task->status = TASK_COMPLETED; // mark task as complete for history hash table
+                // task_cancel() must no longer find it
+                registry_remove(tboard, task);
+                // measure stack this run used, if history asked for it to be probed
+                if (task->stack_probe)
+                    task->stack_used = task_stack_scan(task->ctx);
                 // record task execution statistics into history hash table
                 history_record_exec(tboard, task, &(task->hist)); 
+                // children task never joined free their futures
+                if (task->futures != NULL)
+                    future_abandon(task);
+                // wake parent waiting in task_join_all(), if any
+                if (task->future != NULL)
+                    future_complete(tboard, task->future, true);
 
                 // check if task was blocking, if so we need to resume parent
                 if (task->parent != NULL) { // blocking task just terminated, we wish to return parent to queue
-                    // push result to coroutine storage so blocking_task_create() can process results
-                    assert(mco_push(task->parent->ctx, task, sizeof(task_t)) == MCO_SUCCESS);
+                    // nothing else places parent back, so blocking_task_create() knows we completed
                     // place parent back into appropriate queue
                     task_place(tboard, task->parent); // place parent back in appropriate queue
                 } else {
@@ -156,27 +665,17 @@ void *executor(void *arg)
                     free(task->desc.user_data);
                 // destroy context
                 mco_destroy(task->ctx);
-                // free task_t object
-                free(task);
+                // return task_t object to pool
+                task_free(tboard, task);
                 
                 
             } else {
                 printf("Unexpected status received: %d, will lose task.\n",status);
             }
-
-            // free queue entry
-            free(next);
-        } else { // empty queue, we sleep on appropriate condition variable until signal received
-            if (type == PRIMARY_EXEC) {
-                pthread_mutex_lock(&(tboard->pmutex));
-                pthread_cond_timedwait(&(tboard->pcond), &(tboard->pmutex), &pexec_timeout);
-                pthread_mutex_unlock(&(tboard->pmutex));
-            } else {
-                pthread_mutex_lock(&(tboard->smutex[num]));
-                pthread_cond_wait(&(tboard->scond[num]), &(tboard->smutex[num]));
-                pthread_mutex_unlock(&(tboard->smutex[num]));
-            }
+        } else { // empty queue, spin, yield and finally park until woken
+            executor_idle(tboard, (exec_t *)arg, &idle);
         }
     }
-     
+    current_exec = NULL;
+    return NULL;
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+/**
+ * Contains all functions pertaining to futures of child tasks
+ *
+ * task_spawn() creates a child task with a future that outlives it. A parent waits for its
+ * children with task_join_all(), which keeps a task_join_t on the parent's coroutine stack and
+ * swaps a pointer to it into the future of every child still running. A child that terminates
+ * swaps the sentinel FUTURE_DONE into its future instead, so exactly one of the two sees the
+ * other: either the parent finds the child done, or the child finds the join and drops its
+ * reference on it.
+ *
+ * The parent holds a reference of its own until its executor has taken it off its CPU (see
+ * future_park()), so no child can place it back in a ready queue while it is still running.
+ * Whoever drops the last reference places the parent back.
+ *
+ * A parent released without joining, because it was cancelled or the task board is destroyed,
+ * swaps the sentinel FUTURE_DETACHED into the futures it spawned (see future_abandon()). Again
+ * exactly one of parent and child sees the other, and frees the future.
+ */
+#include "tboard.h"
+#include "future.h"
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <minicoro.h>
+
+#define FUTURE_DONE ((task_join_t *)1) // @join of a future whose child task terminated
+#define FUTURE_DETACHED ((task_join_t *)2) // @join of a future whose parent will never join it
+
+
+static void future_unlink(task_future_t *future)
+{
+    if (future->owner == NULL)
+        return;
+    if (future->prev != NULL)
+        future->prev->next = future->next;
+    else
+        future->owner->futures = future->next;
+    if (future->next != NULL)
+        future->next->prev = future->prev;
+}
+
+void future_complete(tboard_t *t, task_future_t *future, bool completed)
+{
+    future->completed = completed;
+    task_join_t *join = atomic_exchange_explicit(&(future->join), FUTURE_DONE, memory_order_acq_rel);
+    if (join == NULL) // not joined yet, parent finds us done
+        return;
+    if (join == FUTURE_DETACHED) { // parent is gone, we are last to hold future
+        free(future);
+        return;
+    }
+    // join lives on waiter's stack, which may return as soon as we drop our reference
+    task_t *waiter = join->waiter;
+    if (atomic_fetch_sub_explicit(&(join->pending), 1, memory_order_acq_rel) == 1)
+        task_place(t, waiter);
+}
+
+void future_abandon(task_t *task)
+{
+    task_future_t *future = task->futures;
+    task->futures = NULL;
+    while (future != NULL) {
+        task_future_t *next = future->next;
+        if (atomic_exchange_explicit(&(future->join), FUTURE_DETACHED, memory_order_acq_rel) == FUTURE_DONE)
+            free(future); // child terminated already, otherwise it frees future
+        future = next;
+    }
+}
+
+void future_destroy(task_t *task)
+{
+    if (task->futures != NULL)
+        future_abandon(task);
+    task_future_t *future = task->future;
+    if (future == NULL)
+        return;
+    task->future = NULL;
+    task_join_t *join = atomic_exchange_explicit(&(future->join), FUTURE_DONE, memory_order_relaxed);
+    if (join == FUTURE_DETACHED) {
+        free(future);
+    } else if (join != NULL) {
+        // parent is parked in task_join_all(), in no queue. Last child to go takes it along,
+        // which frees this future too
+        task_t *waiter = join->waiter;
+        if (atomic_fetch_sub_explicit(&(join->pending), 1, memory_order_relaxed) == 1)
+            task_destroy(waiter);
+    }
+}
+
+bool future_park(task_t *task, task_join_t *join)
+{
+    (void)task; // placed back through @join->waiter
+    return atomic_fetch_sub_explicit(&(join->pending), 1, memory_order_acq_rel) == 1;
+}
+
+bool task_join(task_future_t *future)
+{
+    return task_join_all(&future, 1);
+}
+
+bool task_join_all(task_future_t **futures, int n)
+{
+    if (mco_running() == NULL) { // must be called from a coroutine!
+        tboard_err("task_join_all: Must be called from a task.\n");
+        return false;
+    }
+    task_join_t join;
+    join.waiter = NULL;
+    atomic_init(&(join.pending), 1); // our own reference, dropped by future_park()
+    for (int i=0; i<n; i++) {
+        if (futures[i] == NULL)
+            continue;
+        if (join.waiter == NULL) { // we are the task our executor is running
+            exec_t *exec = executor_current(futures[i]->tboard);
+            assert(exec != NULL && exec->running != NULL);
+            join.waiter = exec->running;
+        }
+        // count child before it can see the join, so pending never drops to 0 early
+        atomic_fetch_add_explicit(&(join.pending), 1, memory_order_relaxed);
+        task_join_t *expected = NULL;
+        if (!atomic_compare_exchange_strong_explicit(&(futures[i]->join), &expected, &join,
+                                                     memory_order_acq_rel, memory_order_acquire))
+            atomic_fetch_sub_explicit(&(join.pending), 1, memory_order_relaxed); // terminated already
+    }
+    // children can only drop their references, so if none holds one we need not wait
+    if (atomic_load_explicit(&(join.pending), memory_order_acquire) > 1) {
+        executor_yield(YIELD_JOIN, &join, 0); // parked until last child terminates
+    }
+
+    bool completed = true;
+    for (int i=0; i<n; i++) {
+        if (futures[i] == NULL) {
+            completed = false;
+            continue;
+        }
+        completed = completed && futures[i]->completed;
+        future_unlink(futures[i]);
+        free(futures[i]);
+    }
+    return completed;
+}
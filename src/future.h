@@ -0,0 +1,6 @@
+#ifndef __FUTURE_H_
+#define __FUTURE_H_
+/**
+ * Futures of child tasks, prototypes are found in tboard.h
+ */
+#endif
@@ -8,26 +8,75 @@
 #include "history.h"
 #include <uthash.h>
 #include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
 
+#define STACK_PROFILE_BUCKETS (STACK_SIZE / STACK_PROFILE_BUCKET + 1)
 
 
 
-void history_record_exec(tboard_t *t, task_t *task, history_t **hist)
+
+static size_t history_stack_class(size_t peak)
 {
-    pthread_mutex_lock(&(t->hmutex));
+    // smallest stack size class holding STACK_MARGIN times @peak, or the largest one
+    size_t size = STACK_MIN_SIZE;
+    while (size < STACK_SIZE && size < peak * STACK_MARGIN)
+        size <<= 1;
+    return size;
+}
+
+static void history_profile_stack(history_t *hist, size_t used)
+{
+    // @t->hmutex must be held
+    if (hist->stack_hist == NULL) {
+        hist->stack_hist = calloc(STACK_PROFILE_BUCKETS, sizeof(long));
+        if (hist->stack_hist == NULL)
+            return;
+    }
+    size_t bucket = used / STACK_PROFILE_BUCKET;
+    hist->stack_hist[(bucket < STACK_PROFILE_BUCKETS) ? bucket : STACK_PROFILE_BUCKETS - 1]++;
+    hist->stack_profiled++;
+    hist->stack_total += used;
+}
+
+static size_t history_stack_percentile(history_t *hist, double p)
+{
+    // upper bound of histogram bucket holding @p of profiled executions, capped at maximum seen
+    long rank = (long)(p * hist->stack_profiled + 0.999999), seen = 0;
+    for (size_t b=0; b<STACK_PROFILE_BUCKETS; b++) {
+        seen += hist->stack_hist[b];
+        if (seen >= rank) {
+            size_t bound = (b + 1) * STACK_PROFILE_BUCKET;
+            return (bound < hist->stack_peak) ? bound : hist->stack_peak;
+        }
+    }
+    return hist->stack_peak;
+}
+
+static history_t *history_find_or_add(tboard_t *t, const char *fn_name)
+{
+    // @t->hmutex must be held
+    history_t *hist = NULL;
     // check if function exists in hash table
-    HASH_FIND_STR(t->exec_hist, task->fn.fn_name, *hist);
-
-    if (*hist == NULL) { // does not exist, so we create it
-        *hist = calloc(1, sizeof(history_t));
-        (*hist)->fn_name = calloc(strlen(task->fn.fn_name)+1, sizeof(char));
-        strcpy((*hist)->fn_name, task->fn.fn_name);
-        (*hist)->mean_t = 0;
-        (*hist)->mean_yield = 0;
-        (*hist)->executions = 0;
-        (*hist)->completions = 0;
-        HASH_ADD_KEYPTR(hh, t->exec_hist, (*hist)->fn_name, strlen((*hist)->fn_name), *hist);
+    HASH_FIND_STR(t->exec_hist, fn_name, hist);
+
+    if (hist == NULL) { // does not exist, so we create it
+        hist = calloc(1, sizeof(history_t));
+        hist->fn_name = calloc(strlen(fn_name)+1, sizeof(char));
+        strcpy(hist->fn_name, fn_name);
+        hist->mean_t = 0;
+        hist->mean_yield = 0;
+        hist->executions = 0;
+        hist->completions = 0;
+        HASH_ADD_KEYPTR(hh, t->exec_hist, hist->fn_name, strlen(hist->fn_name), hist);
     }
+    return hist;
+}
+
+void history_record_exec(tboard_t *t, task_t *task, history_t **hist)
+{
+    pthread_mutex_lock(&(t->hmutex));
+    *hist = history_find_or_add(t, task->fn.fn_name);
 
     
     if(task->status == TASK_COMPLETED){ // if task is completed, we update specific values
@@ -36,12 +85,94 @@ void history_record_exec(tboard_t *t, task_t *task, history_t **hist)
         (*hist)->mean_t     = (((*hist)->mean_t)*((*hist)->completions) + task->cpu_time) / (((*hist)->completions) + 1);
         (*hist)->mean_yield = (((*hist)->mean_yield)*((*hist)->completions) + task->yields) / (((*hist)->completions) + 1);
         (*hist)->completions += 1; // increment completion count
+        if (task->stack_probe) { // stack size class follows deepest probed execution
+            (*hist)->stack_probes += 1;
+            if (task->stack_used > (*hist)->stack_peak)
+                (*hist)->stack_peak = task->stack_used;
+            if (!(*hist)->stack_pinned)
+                (*hist)->stack_size = history_stack_class((*hist)->stack_peak);
+            if (t->stack_profile)
+                history_profile_stack(*hist, task->stack_used);
+        }
     }
     // if task is incomplete, relevant values are added automatically in task board functions
     pthread_mutex_unlock(&(t->hmutex));
 }
 
 
+size_t history_stack_size(tboard_t *t, task_t *task, int n)
+{
+    pthread_mutex_lock(&(t->hmutex));
+    history_t *hist = history_find_or_add(t, task->fn.fn_name);
+    // probe until enough executions completed, then whenever one of the next @n runs is due
+    bool sizing = t->stack_sizing && !hist->stack_pinned;
+    long due = hist->stack_runs % STACK_PROBE_INTERVAL;
+    bool probe = sizing && (hist->stack_probes < STACK_PROBE_RUNS || hist->stack_size == 0
+              || due == 0 || due + n > STACK_PROBE_INTERVAL);
+    if (sizing)
+        hist->stack_runs += n;
+    size_t size = (sizing && !probe) ? hist->stack_size : STACK_SIZE;
+    pthread_mutex_unlock(&(t->hmutex));
+    task->hist = hist;
+    task->stack_probe = probe || t->stack_profile; // profiled stacks keep their class
+    task->stack_used = 0;
+    task->stack_guard = size < STACK_SIZE;
+    return size;
+}
+
+int64_t history_range_grain(tboard_t *t, const char *fn_name)
+{
+    pthread_mutex_lock(&(t->hmutex));
+    history_t *hist = history_find_or_add(t, fn_name);
+    // elements that take about PARALLEL_SLICE, going by mean time per element so far
+    int64_t grain = 1;
+    if (hist->range_iters > 0 && hist->range_time > 0)
+        grain = (int64_t)((double)PARALLEL_SLICE * hist->range_iters / hist->range_time);
+    pthread_mutex_unlock(&(t->hmutex));
+    return (grain > 1) ? grain : 1;
+}
+
+void history_record_range(tboard_t *t, const char *fn_name, uint64_t iters, uint64_t ns)
+{
+    pthread_mutex_lock(&(t->hmutex));
+    history_t *hist = history_find_or_add(t, fn_name);
+    hist->range_iters += iters;
+    hist->range_time += ns;
+    pthread_mutex_unlock(&(t->hmutex));
+}
+
+void history_record_batch(tboard_t *t, task_t **tasks, int n)
+{
+    history_t *hist = NULL;
+    pthread_mutex_lock(&(t->hmutex));
+    for (int i=0; i<n; i++) {
+        // batches usually share one function, so only search when it changes
+        if (hist == NULL || strcmp(hist->fn_name, tasks[i]->fn.fn_name) != 0)
+            hist = history_find_or_add(t, tasks[i]->fn.fn_name);
+        tasks[i]->hist = hist;
+        hist->executions += 1; // increase execution count
+    }
+    pthread_mutex_unlock(&(t->hmutex));
+}
+
+void history_pin_stack(tboard_t *t, history_t *hist)
+{
+    pthread_mutex_lock(&(t->hmutex));
+    hist->stack_pinned = true;
+    hist->stack_size = STACK_SIZE;
+    pthread_mutex_unlock(&(t->hmutex));
+}
+
+void history_record_overrun(tboard_t *t, history_t *hist, uint64_t slice, bool flagged)
+{
+    pthread_mutex_lock(&(t->hmutex));
+    if (flagged)
+        hist->overruns += 1;
+    if (slice > hist->max_slice)
+        hist->max_slice = slice;
+    pthread_mutex_unlock(&(t->hmutex));
+}
+
 void history_fetch_exec(tboard_t *t, function_t *func, history_t **hist)
 {
     // search for entry by function name
@@ -58,8 +189,9 @@ void history_destroy(tboard_t *t)
     HASH_ITER(hh, t->exec_hist, entry, temp) {
         // delete hash table index
         HASH_DEL(t->exec_hist, entry);
-        // free function name buffer
+        // free function name buffer and stack usage histogram
         free(entry->fn_name);
+        free(entry->stack_hist);
         // free hash table entry
         free(entry);
     }
@@ -97,6 +229,19 @@ void history_print_records(tboard_t *t, FILE *fptr)
         // print values
         fprintf(fptr, "History: task '%s' completed %d/%d times, yielding %.0f times (average %f) with mean execution CPU time of %.7f s\n", 
             entry->fn_name, entry->completions, entry->executions, entry->yields, entry->mean_yield, entry->mean_t / CLOCKS_PER_SEC);
+        if (entry->stack_probes > 0)
+            fprintf(fptr, "History: task '%s' used at most %zu stack bytes in %d probed runs, runs with %zu byte stacks\n",
+                entry->fn_name, entry->stack_peak, entry->stack_probes, entry->stack_size);
+        if (entry->stack_profiled > 0)
+            fprintf(fptr, "History: task '%s' stack usage over %ld profiled runs: mean %.0f, p99 %zu, max %zu bytes\n",
+                entry->fn_name, entry->stack_profiled, (double)entry->stack_total / entry->stack_profiled,
+                history_stack_percentile(entry, 0.99), entry->stack_peak);
+        if (entry->range_iters > 0)
+            fprintf(fptr, "History: range '%s' handled %" PRIu64 " elements in parallel, %.1f ns per element\n",
+                entry->fn_name, entry->range_iters, (double)entry->range_time / entry->range_iters);
+        if (entry->overruns > 0)
+            fprintf(fptr, "History: task '%s' overran slice budget %d times, longest slice %.3f ms\n",
+                entry->fn_name, entry->overruns, entry->max_slice / 1e6);
     }
     pthread_mutex_unlock(&(t->hmutex));
 }
\ No newline at end of file
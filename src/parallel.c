@@ -0,0 +1,317 @@
+/**
+ * Contains all functions pertaining to parallel loops over the task board
+ *
+ * tboard_parallel_for() and tboard_parallel_reduce() split their range by lazy binary
+ * splitting. A task works through its part of the range a grain at a time, and before each
+ * grain checks whether an sExecutor may be looking for work. Only then does it split off the
+ * upper half of what it has left as a new secondary task (see task_spawn()), so ranges are
+ * split about as often as sExecutors run dry, however large they are.
+ *
+ * Every task joins the tasks it split off once its own part is done. When reducing, their
+ * accumulators are combined into its own in range order: a task's own part is always the
+ * lowest, and every split takes the part right above it, so the most recent split comes next.
+ *
+ * Parts are kept on their job until the whole range is done, rather than freed once joined, so
+ * nothing is left behind by tasks that never terminate. A thread that is not a task starts the
+ * range on a root task and waits for it. Their job is shared by both and listed on the task
+ * board until the root task terminates, and if task board is destroyed first, parallel_destroy()
+ * lets go of it in the root task's stead.
+ */
+#include "tboard.h"
+#include "parallel.h"
+#include "queue/deque.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include <minicoro.h>
+
+struct parallel_job {
+    tboard_t *t;
+    range_function_t fn;
+    function_t task_fn; // parallel_task(), named after @fn so history tells ranges apart
+    tb_combine_f combine;
+    void *ctx;
+    int64_t grain; // 0 or less sizes grain from history
+    const void *identity;
+    size_t acc_size;
+    _Atomic(struct parallel_part *) parts; // every part of the range, freed along with job
+    // caller waits here unless it is a task
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool done;
+    bool aborted; // task board was destroyed before root task terminated
+    atomic_int refs; // caller, and root task until it terminates or parallel_destroy() lets go for it
+    struct parallel_job *pending; // next job in @t->parallel_jobs
+};
+
+struct parallel_part {
+    struct parallel_job *job;
+    int64_t begin;
+    int64_t end;
+    bool completed;
+    bool root; // started for a thread that is not a task, which waits for it
+    task_future_t *future;
+    struct parallel_part *next; // next part split off by same task, higher up the range
+    struct parallel_part *chain; // next part in @job->parts
+    _Alignas(max_align_t) unsigned char acc[];
+};
+
+static void parallel_task(context_t ctx);
+static void parallel_release(struct parallel_job *job);
+static void parallel_unlist(struct parallel_job *job);
+
+
+static struct parallel_part *parallel_part_new(struct parallel_job *job, int64_t begin, int64_t end)
+{
+    struct parallel_part *part = malloc(sizeof(struct parallel_part) + job->acc_size); // free'd with job
+    if (part == NULL)
+        return NULL;
+    part->job = job;
+    part->begin = begin;
+    part->end = end;
+    part->completed = false;
+    part->root = false;
+    part->future = NULL;
+    part->next = NULL;
+    if (job->acc_size > 0)
+        memcpy(part->acc, job->identity, job->acc_size);
+    // parts outlive the tasks that split them off, should task board be destroyed mid-range
+    part->chain = atomic_load_explicit(&(job->parts), memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&(job->parts), &(part->chain), part,
+                                                  memory_order_release, memory_order_relaxed))
+        ;
+    return part;
+}
+
+static bool parallel_hungry(tboard_t *t)
+{
+    // a parked sExecutor is woken by the split, and one whose deque is empty steals it
+    if (atomic_load_explicit(&(t->idle_count), memory_order_relaxed) > 0)
+        return true;
+    exec_t *exec = executor_current(t);
+    return exec != NULL && exec->type == SECONDARY_EXEC && deque_size(&(t->sdeque[exec->num])) == 0;
+}
+
+static void parallel_run(struct parallel_part *part)
+{
+    struct parallel_job *job = part->job;
+    tboard_t *t = job->t;
+    int64_t grain = (job->grain > 0) ? job->grain : history_range_grain(t, job->fn.fn_name);
+    struct parallel_part *splits = NULL;
+    int64_t cur = part->begin, end = part->end;
+    uint64_t iters = 0, spent = 0;
+
+    while (cur < end) {
+        if (end - cur > grain && parallel_hungry(t)) {
+            // hand upper half of what is left to a new task, unless task board is full
+            int64_t mid = cur + (end - cur) / 2;
+            struct parallel_part *split = parallel_part_new(job, mid, end);
+            if (split != NULL)
+                split->future = task_spawn(t, job->task_fn, SECONDARY_EXEC, split, 0);
+            if (split != NULL && split->future != NULL) {
+                split->next = splits;
+                splits = split;
+                end = mid;
+            }
+        }
+        int64_t stop = (end - cur > grain) ? cur + grain : end;
+        uint64_t start = timer_now();
+        if (job->fn.reduce != NULL)
+            job->fn.reduce(cur, stop, job->ctx, part->acc);
+        else
+            job->fn.range(cur, stop, job->ctx);
+        uint64_t ns = timer_now() - start;
+        if (job->grain <= 0 && ns > 0) { // aim for PARALLEL_SLICE, growing at most twofold per grain
+            int64_t next = (int64_t)((double)PARALLEL_SLICE * (stop - cur) / ns);
+            grain = (next < 1) ? 1 : (next > 2 * grain) ? 2 * grain : next;
+        }
+        iters += stop - cur;
+        spent += ns;
+        cur = stop;
+        if (cur < end)
+            task_yield();
+    }
+    history_record_range(t, job->fn.fn_name, iters, spent);
+
+    // fan in, in range order
+    bool completed = true;
+    while (splits != NULL) {
+        struct parallel_part *split = splits;
+        splits = split->next;
+        if (task_join(split->future) && split->completed) {
+            if (job->combine != NULL)
+                job->combine(part->acc, split->acc, job->ctx);
+        } else {
+            completed = false;
+        }
+    }
+    part->completed = completed;
+}
+
+static void parallel_task(context_t ctx)
+{
+    (void)ctx;
+    struct parallel_part *part = (struct parallel_part *)task_get_args();
+    parallel_run(part);
+    if (part->root) { // calling thread waits for us
+        struct parallel_job *job = part->job;
+        parallel_unlist(job);
+        pthread_mutex_lock(&(job->mutex));
+        job->done = true;
+        pthread_cond_signal(&(job->cond));
+        pthread_mutex_unlock(&(job->mutex));
+        parallel_release(job);
+    }
+}
+
+static void parallel_free_parts(struct parallel_job *job)
+{
+    struct parallel_part *part = atomic_load_explicit(&(job->parts), memory_order_acquire);
+    while (part != NULL) {
+        struct parallel_part *chain = part->chain;
+        free(part);
+        part = chain;
+    }
+}
+
+static void parallel_release(struct parallel_job *job)
+{
+    if (atomic_fetch_sub(&(job->refs), 1) > 1)
+        return;
+    pthread_cond_destroy(&(job->cond));
+    pthread_mutex_destroy(&(job->mutex));
+    parallel_free_parts(job);
+    free(job);
+}
+
+static void parallel_unlist(struct parallel_job *job)
+{
+    tboard_t *t = job->t;
+    pthread_mutex_lock(&(t->parallel_mutex));
+    struct parallel_job **link = &(t->parallel_jobs);
+    while (*link != NULL && *link != job)
+        link = &((*link)->pending);
+    if (*link != NULL)
+        *link = job->pending;
+    pthread_mutex_unlock(&(t->parallel_mutex));
+}
+
+void parallel_destroy(tboard_t *t)
+{
+    // executors are joined, so root tasks still listed never terminate. Let go for them
+    pthread_mutex_lock(&(t->parallel_mutex));
+    struct parallel_job *job = t->parallel_jobs;
+    t->parallel_jobs = NULL;
+    pthread_mutex_unlock(&(t->parallel_mutex));
+    while (job != NULL) {
+        struct parallel_job *pending = job->pending;
+        pthread_mutex_lock(&(job->mutex));
+        job->aborted = true; // caller stops waiting, without looking at task board again
+        pthread_cond_signal(&(job->cond));
+        pthread_mutex_unlock(&(job->mutex));
+        parallel_release(job);
+        job = pending;
+    }
+}
+
+static bool parallel_start(struct parallel_job *job, int64_t begin, int64_t end, void *acc)
+{
+    tboard_t *t = job->t;
+    bool completed;
+    if (mco_running() != NULL) { // we are a task, so we run the range ourselves
+        atomic_init(&(job->parts), NULL);
+        struct parallel_part *root = parallel_part_new(job, begin, end);
+        if (root == NULL)
+            return false;
+        parallel_run(root);
+        completed = root->completed;
+        if (completed && job->acc_size > 0)
+            memcpy(acc, root->acc, job->acc_size);
+        parallel_free_parts(job);
+        return completed;
+    }
+
+    // nothing would ever run the root task
+    if (t->status != 1 || t->shutdown != 0)
+        return false;
+    // root task may outlive us should task board shut down while we wait, so job leaves our stack
+    struct parallel_job *shared = malloc(sizeof(struct parallel_job));
+    if (shared == NULL)
+        return false;
+    *shared = *job;
+    atomic_init(&(shared->parts), NULL);
+    pthread_mutex_init(&(shared->mutex), NULL);
+    pthread_cond_init(&(shared->cond), NULL);
+    shared->done = false;
+    shared->aborted = false;
+    atomic_init(&(shared->refs), 2);
+    struct parallel_part *root = parallel_part_new(shared, begin, end);
+    if (root == NULL) {
+        atomic_store(&(shared->refs), 1);
+        parallel_release(shared);
+        return false;
+    }
+    root->root = true;
+    // listed before root task can terminate, which takes it off again
+    pthread_mutex_lock(&(t->parallel_mutex));
+    shared->pending = t->parallel_jobs;
+    t->parallel_jobs = shared;
+    pthread_mutex_unlock(&(t->parallel_mutex));
+    if (!task_create(t, shared->task_fn, SECONDARY_EXEC, root, 0)) {
+        parallel_unlist(shared);
+        atomic_store(&(shared->refs), 1);
+        parallel_release(shared);
+        return false;
+    }
+
+    // wait for root task, checking every PARALLEL_WAIT ns whether task board was killed meanwhile.
+    // Task board is only looked at while not aborted, parallel_destroy() aborts us before it is freed
+    pthread_mutex_lock(&(shared->mutex));
+    while (!shared->done && !shared->aborted && t->shutdown == 0) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += PARALLEL_WAIT;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&(shared->cond), &(shared->mutex), &deadline);
+    }
+    completed = shared->done && root->completed;
+    pthread_mutex_unlock(&(shared->mutex));
+    if (completed && job->acc_size > 0)
+        memcpy(acc, root->acc, job->acc_size);
+    parallel_release(shared);
+    return completed;
+}
+
+bool tboard_parallel_for(tboard_t *t, int64_t begin, int64_t end, int64_t grain, range_function_t fn, void *ctx)
+{
+    if (t == NULL || fn.range == NULL)
+        return false;
+    if (begin >= end)
+        return true;
+    struct parallel_job job = {
+        .t = t, .fn = fn, .task_fn = {.fn = parallel_task, .fn_name = fn.fn_name},
+        .combine = NULL, .ctx = ctx, .grain = grain, .identity = NULL, .acc_size = 0,
+    };
+    return parallel_start(&job, begin, end, NULL);
+}
+
+bool tboard_parallel_reduce(tboard_t *t, int64_t begin, int64_t end, int64_t grain, range_function_t fn,
+                            tb_combine_f combine, void *ctx, void *acc, size_t acc_size)
+{
+    if (t == NULL || fn.reduce == NULL || combine == NULL || acc == NULL || acc_size == 0)
+        return false;
+    if (begin >= end)
+        return true;
+    struct parallel_job job = {
+        .t = t, .fn = fn, .task_fn = {.fn = parallel_task, .fn_name = fn.fn_name},
+        .combine = combine, .ctx = ctx, .grain = grain, .identity = acc, .acc_size = acc_size,
+    };
+    return parallel_start(&job, begin, end, acc);
+}
@@ -0,0 +1,6 @@
+#ifndef __PARALLEL_H_
+#define __PARALLEL_H_
+/**
+ * Parallel loops over the task board, prototypes are found in tboard.h
+ */
+#endif
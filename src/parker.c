@@ -0,0 +1,89 @@
+/**
+ * Thread parker for idle task executors. See parker.h.
+ */
+#define _GNU_SOURCE
+
+#include "parker.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+
+void parker_init(parker_t *p)
+{
+    atomic_init(&(p->state), PARKER_EMPTY);
+#ifndef __linux__
+    pthread_mutex_init(&(p->mutex), NULL);
+    pthread_cond_init(&(p->cond), NULL);
+#endif
+}
+
+void parker_destroy(parker_t *p)
+{
+#ifndef __linux__
+    pthread_mutex_destroy(&(p->mutex));
+    pthread_cond_destroy(&(p->cond));
+#else
+    (void)p;
+#endif
+}
+
+#ifdef __linux__
+
+bool parker_park(parker_t *p, const struct timespec *timeout)
+{
+    // NOTIFIED -> EMPTY consumes permit without sleeping, EMPTY -> PARKED announces we sleep
+    if (atomic_fetch_sub(&(p->state), 1) == PARKER_NOTIFIED)
+        return true;
+    // FUTEX_WAIT returns immediately if state is no longer PARKED, so an unpark cannot be missed
+    syscall(SYS_futex, &(p->state), FUTEX_WAIT_PRIVATE, PARKER_PARKED, timeout, NULL, 0);
+    // woken, timed out or spurious: leave EMPTY either way, reporting whether we were notified
+    return atomic_exchange(&(p->state), PARKER_EMPTY) == PARKER_NOTIFIED;
+}
+
+void parker_unpark(parker_t *p)
+{
+    if (atomic_exchange(&(p->state), PARKER_NOTIFIED) == PARKER_PARKED)
+        syscall(SYS_futex, &(p->state), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+#else
+
+bool parker_park(parker_t *p, const struct timespec *timeout)
+{
+    if (atomic_fetch_sub(&(p->state), 1) == PARKER_NOTIFIED)
+        return true;
+    pthread_mutex_lock(&(p->mutex));
+    if (atomic_load(&(p->state)) == PARKER_PARKED) {
+        if (timeout != NULL) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += timeout->tv_sec;
+            deadline.tv_nsec += timeout->tv_nsec;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&(p->cond), &(p->mutex), &deadline);
+        } else {
+            pthread_cond_wait(&(p->cond), &(p->mutex));
+        }
+    }
+    pthread_mutex_unlock(&(p->mutex));
+    return atomic_exchange(&(p->state), PARKER_EMPTY) == PARKER_NOTIFIED;
+}
+
+void parker_unpark(parker_t *p)
+{
+    if (atomic_exchange(&(p->state), PARKER_NOTIFIED) == PARKER_PARKED) {
+        // taking mutex orders us after owner's check of state in parker_park()
+        pthread_mutex_lock(&(p->mutex));
+        pthread_cond_signal(&(p->cond));
+        pthread_mutex_unlock(&(p->mutex));
+    }
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef __PARKER_H_
+#define __PARKER_H_
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifndef __linux__
+#include <pthread.h>
+#endif
+
+/**
+ * parker_t - One-permit thread parker, used by idle task executors.
+ * @state: PARKER_EMPTY, PARKER_PARKED while owner is parked, or PARKER_NOTIFIED
+ *         when a permit is available
+ * 
+ * Only the owning thread calls parker_park(), any thread may call parker_unpark().
+ * An unpark that arrives before the owner parks leaves a permit, so the next
+ * parker_park() returns immediately and wakeups are never lost. Permits do not
+ * accumulate.
+ * 
+ * On Linux parking is a futex wait on @state, elsewhere a mutex and condition
+ * variable are used.
+ */
+typedef struct {
+    atomic_int state;
+#ifndef __linux__
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+} parker_t;
+
+#define PARKER_PARKED -1
+#define PARKER_EMPTY 0
+#define PARKER_NOTIFIED 1
+
+void parker_init(parker_t *p);
+
+void parker_destroy(parker_t *p);
+
+bool parker_park(parker_t *p, const struct timespec *timeout);
+/**
+ * parker_park() - Blocks calling thread until permit is available
+ * @p:       parker owned by calling thread
+ * @timeout: maximum time to block, relative. NULL blocks until unparked
+ * 
+ * Consumes permit. May return early on spurious wakeups, callers recheck their condition.
+ * 
+ * Return: true if a permit was consumed, false on timeout or spurious wakeup
+ */
+
+void parker_unpark(parker_t *p);
+/**
+ * parker_unpark() - Makes permit available, waking owner of @p if it is parked
+ * @p: parker to unpark
+ */
+
+static inline void cpu_relax(void)
+{
+    // tell the core we are spinning, so a sibling hyperthread gets the pipeline
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#else
+    atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+#endif
@@ -0,0 +1,312 @@
+/**
+ * Object pools for task board structures that are created and destroyed at a high
+ * rate (task_t, remote_task_t, coroutine contexts and their stacks).
+ *
+ * Each pool has a shared free list guarded by a mutex. Each task executor keeps a
+ * small cache per pool in its exec_t, which it refills from and spills to the shared
+ * free list in batches, so the common case of an executor allocating and freeing
+ * tasks touches neither the shared mutex nor malloc. Threads that are not task
+ * executors (MQTT adapter, user threads) use the shared free list directly.
+ *
+ * Pooled objects are individually allocated with malloc(), so an object that is not
+ * returned to its pool can always be released with free().
+ *
+ * Coroutine contexts come in STACK_CLASSES sizes, with one pool per stack size class. Which
+ * class a task gets is decided by history_stack_size(), from stack usage measured by painting
+ * stacks with task_stack_paint() and scanning them with task_stack_scan(), once sizing is enabled
+ * (see tboard_set_stack_sizing()). Downsized stacks are guarded by task_stack_guard().
+ */
+
+#include "tboard.h"
+#include "pool.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+
+// free list link lives in the first word of a free object
+#define POOL_NEXT(obj) (*(void **)(obj))
+
+#define STACK_PAINT 0x5a17ab1e5a17ab1eULL // pattern filling unused coroutine stack while probing
+#define STACK_PAINT_SKIP 256 // bytes at top of stack left unpainted
+
+
+void pool_init(pool_t *p, size_t size, int capacity, int cache_size, bool zero)
+{
+    p->size = (size < sizeof(void *)) ? sizeof(void *) : size;
+    p->capacity = capacity;
+    p->cache_size = cache_size;
+    p->batch = (cache_size > 1) ? cache_size / 2 : 1;
+    p->zero = zero;
+    p->count = 0;
+    p->free = NULL;
+    atomic_init(&(p->hits), 0);
+    atomic_init(&(p->misses), 0);
+    pthread_mutex_init(&(p->mutex), NULL);
+}
+
+void pool_destroy(pool_t *p)
+{
+    pthread_mutex_lock(&(p->mutex));
+    while (p->free != NULL) {
+        void *obj = p->free;
+        p->free = POOL_NEXT(obj);
+        free(obj);
+    }
+    p->count = 0;
+    pthread_mutex_unlock(&(p->mutex));
+    pthread_mutex_destroy(&(p->mutex));
+}
+
+void pool_cache_destroy(pool_cache_t *c)
+{
+    while (c->free != NULL) {
+        void *obj = c->free;
+        c->free = POOL_NEXT(obj);
+        free(obj);
+    }
+    c->count = 0;
+}
+
+static void pool_cache_refill(pool_t *p, pool_cache_t *c)
+{
+    // move up to @p->batch objects from shared free list into executor cache
+    pthread_mutex_lock(&(p->mutex));
+    for (int i=0; i<p->batch && p->free != NULL; i++) {
+        void *obj = p->free;
+        p->free = POOL_NEXT(obj);
+        p->count--;
+        POOL_NEXT(obj) = c->free;
+        c->free = obj;
+        c->count++;
+    }
+    pthread_mutex_unlock(&(p->mutex));
+}
+
+static void pool_cache_spill(pool_t *p, pool_cache_t *c)
+{
+    // return @p->batch objects from executor cache to shared free list, releasing
+    // any that would exceed the pool capacity
+    pthread_mutex_lock(&(p->mutex));
+    for (int i=0; i<p->batch && c->free != NULL; i++) {
+        void *obj = c->free;
+        c->free = POOL_NEXT(obj);
+        c->count--;
+        if (p->count < p->capacity) {
+            POOL_NEXT(obj) = p->free;
+            p->free = obj;
+            p->count++;
+        } else {
+            free(obj);
+        }
+    }
+    pthread_mutex_unlock(&(p->mutex));
+}
+
+void pool_cache_prefill(pool_t *p, pool_cache_t *c, int n)
+{
+    // allocate and touch objects from the executor itself, so their pages are placed on its
+    // NUMA node under the default first-touch policy
+    for (int i=0; i<n && c->count < p->cache_size; i++) {
+        void *obj = malloc(p->size);
+        if (obj == NULL)
+            return;
+        memset(obj, 0, p->size);
+        POOL_NEXT(obj) = c->free;
+        c->free = obj;
+        c->count++;
+    }
+}
+
+void *pool_alloc(pool_t *p, pool_cache_t *c)
+{
+    void *obj = NULL;
+    if (c != NULL) { // executor thread, use its cache
+        if (c->free == NULL)
+            pool_cache_refill(p, c);
+        if (c->free != NULL) {
+            obj = c->free;
+            c->free = POOL_NEXT(obj);
+            c->count--;
+            c->hits++;
+        } else {
+            c->misses++;
+        }
+    } else { // any other thread goes to shared free list
+        pthread_mutex_lock(&(p->mutex));
+        if (p->free != NULL) {
+            obj = p->free;
+            p->free = POOL_NEXT(obj);
+            p->count--;
+        }
+        pthread_mutex_unlock(&(p->mutex));
+        atomic_fetch_add_explicit((obj != NULL) ? &(p->hits) : &(p->misses), 1, memory_order_relaxed);
+    }
+
+    if (obj == NULL) // pool is empty, fall back on allocator
+        return (p->zero) ? calloc(1, p->size) : malloc(p->size);
+    if (p->zero) // callers expect calloc() semantics
+        memset(obj, 0, p->size);
+    return obj;
+}
+
+void pool_free(pool_t *p, pool_cache_t *c, void *obj)
+{
+    if (obj == NULL)
+        return;
+    if (c != NULL) {
+        POOL_NEXT(obj) = c->free;
+        c->free = obj;
+        c->count++;
+        if (c->count > p->cache_size)
+            pool_cache_spill(p, c);
+        return;
+    }
+    pthread_mutex_lock(&(p->mutex));
+    if (p->count < p->capacity) {
+        POOL_NEXT(obj) = p->free;
+        p->free = obj;
+        p->count++;
+        obj = NULL;
+    }
+    pthread_mutex_unlock(&(p->mutex));
+    free(obj); // NULL if it was retained
+}
+
+
+/////////////////////////////////////////////
+//////// Task board object wrappers /////////
+/////////////////////////////////////////////
+
+task_t *task_alloc(tboard_t *t)
+{
+    exec_t *exec = executor_current(t);
+    return (task_t *)pool_alloc(&(t->task_pool), (exec != NULL) ? &(exec->task_cache) : NULL);
+}
+
+void task_free(tboard_t *t, task_t *task)
+{
+    exec_t *exec = executor_current(t);
+    pool_free(&(t->task_pool), (exec != NULL) ? &(exec->task_cache) : NULL, task);
+}
+
+remote_task_t *remote_task_alloc(tboard_t *t)
+{
+    exec_t *exec = executor_current(t);
+    return (remote_task_t *)pool_alloc(&(t->rtask_pool), (exec != NULL) ? &(exec->rtask_cache) : NULL);
+}
+
+void remote_task_free(tboard_t *t, remote_task_t *rtask)
+{
+    exec_t *exec = executor_current(t);
+    pool_free(&(t->rtask_pool), (exec != NULL) ? &(exec->rtask_cache) : NULL, rtask);
+}
+
+void *task_stack_alloc(size_t size, void *allocator_data)
+{
+    tboard_t *t = (tboard_t *)allocator_data;
+    // every coroutine of a task board is described by task_desc_init(), so size is that of a class
+    int k = 0;
+    while (k < STACK_CLASSES - 1 && size != t->stack_pool[k].size)
+        k++;
+    assert(size == t->stack_pool[k].size);
+    exec_t *exec = executor_current(t);
+    return pool_alloc(&(t->stack_pool[k]), (exec != NULL) ? &(exec->stack_cache[k]) : NULL);
+}
+
+void task_stack_free(void *ptr, void *allocator_data)
+{
+    tboard_t *t = (tboard_t *)allocator_data;
+    // mco_uninit() leaves stack size in place, classes double from STACK_MIN_SIZE
+    size_t stack_size = ((mco_coro *)ptr)->stack_size;
+    int k = 0;
+    while (k < STACK_CLASSES - 1 && ((size_t)STACK_MIN_SIZE << k) != stack_size)
+        k++;
+    exec_t *exec = executor_current(t);
+    pool_free(&(t->stack_pool[k]), (exec != NULL) ? &(exec->stack_cache[k]) : NULL, ptr);
+}
+
+void task_stack_paint(context_t ctx)
+{
+    // top of stack already holds the frame mco_create() set up, leave it alone
+    uint64_t *word = (uint64_t *)ctx->stack_base;
+    size_t n = (ctx->stack_size - STACK_PAINT_SKIP) / sizeof(uint64_t);
+    for (size_t i=0; i<n; i++)
+        word[i] = STACK_PAINT;
+}
+
+void task_stack_guard(context_t ctx)
+{
+    // stacks grow down, towards stack_base
+    uint64_t *word = (uint64_t *)ctx->stack_base;
+    for (size_t i=0; i<STACK_GUARD / sizeof(uint64_t); i++)
+        word[i] = STACK_PAINT;
+}
+
+bool task_stack_check(context_t ctx)
+{
+    const uint64_t *word = (const uint64_t *)ctx->stack_base;
+    for (size_t i=0; i<STACK_GUARD / sizeof(uint64_t); i++) {
+        if (word[i] != STACK_PAINT)
+            return false;
+    }
+    return true;
+}
+
+size_t task_stack_scan(context_t ctx)
+{
+    const uint64_t *word = (const uint64_t *)ctx->stack_base;
+    size_t n = (ctx->stack_size - STACK_PAINT_SKIP) / sizeof(uint64_t);
+    size_t i = 0;
+    while (i < n && word[i] == STACK_PAINT)
+        i++;
+    return ctx->stack_size - i * sizeof(uint64_t);
+}
+
+static pool_cache_t *pool_exec_cache(exec_t *exec, int k)
+{
+    switch (k) {
+        case 0:  return &(exec->task_cache);
+        case 1:  return &(exec->rtask_cache);
+        default: return &(exec->stack_cache[k - 2]);
+    }
+}
+
+static void pool_print_line(FILE *fptr, const char *name, exec_t *exec, pool_cache_t *c)
+{
+    long total = c->hits + c->misses;
+    fprintf(fptr, "Pool: %s cache of %s %d: %ld hits, %ld misses (%.2f%% hit rate), %d cached\n",
+        name, (exec->type == PRIMARY_EXEC) ? "pExec" : "sExec", exec->num, c->hits, c->misses,
+        (total > 0) ? 100.0 * c->hits / total : 0.0, c->count);
+}
+
+void pool_print_stats(tboard_t *t, FILE *fptr)
+{
+    pool_t *pools[2 + STACK_CLASSES] = {&(t->task_pool), &(t->rtask_pool)};
+    char names[2 + STACK_CLASSES][32] = {"task_t", "remote_task_t"};
+    for (int k=0; k<STACK_CLASSES; k++) {
+        pools[2 + k] = &(t->stack_pool[k]);
+        snprintf(names[2 + k], sizeof(names[2 + k]), "%d byte stack", STACK_MIN_SIZE << k);
+    }
+    for (int k=0; k<2 + STACK_CLASSES; k++) {
+        // shared counters only count allocations made outside of executor threads
+        long hits = atomic_load(&(pools[k]->hits)), misses = atomic_load(&(pools[k]->misses));
+        for (int i=-1, smax=atomic_load_explicit(&(t->smax), memory_order_acquire); i<smax; i++) {
+            exec_t *exec = (i < 0) ? t->pexect : atomic_load_explicit(&(t->sexect[i]), memory_order_acquire);
+            if (exec == NULL) // task board was not started
+                continue;
+            pool_cache_t *c = pool_exec_cache(exec, k);
+            pool_print_line(fptr, names[k], exec, c);
+            hits += c->hits; misses += c->misses;
+        }
+        pthread_mutex_lock(&(pools[k]->mutex));
+        int shared = pools[k]->count;
+        pthread_mutex_unlock(&(pools[k]->mutex));
+        fprintf(fptr, "Pool: %s total: %ld hits, %ld misses (%.2f%% hit rate), %d in shared free list\n",
+            names[k], hits, misses, (hits + misses > 0) ? 100.0 * hits / (hits + misses) : 0.0, shared);
+    }
+}
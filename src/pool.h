@@ -0,0 +1,9 @@
+#ifndef __POOL_H_
+#define __POOL_H_
+
+/**
+ * Pool types and functions are defined in tboard.h as they are embedded in tboard_t
+ * and exec_t. Internal helpers for pool.c should be defined here.
+ */
+
+#endif
@@ -12,23 +12,39 @@ bool msg_processor(tboard_t *t, msg_t *msg)
     switch (msg->type) {
         case TASK_EXEC: // controller wants to create local task
             ;
-            // copy task_t 
-            task_t *task = calloc(1, sizeof(task_t)); // freed by executor
-            memcpy(task, msg->data, sizeof(task_t)); // msg->data free'd by MQTT
+            // only function of msg->data is taken, it is free'd by MQTT and its internal state is not ours
+            task_t *task = task_alloc(t); // zeroed, returned to pool by executor
+            if (task == NULL) {
+                tboard_err("msg_processor: Failed to allocate task.\n");
+                return false;
+            }
             task->status = TASK_INITIALIZED;
-            task->id = TASK_ID_REMOTE_ISSUED;
-            task->parent = NULL;
-            task->cpu_time = 0; // no time has been spent executing
+            task->id = 0; // assigned by task_add()
+            task->fn = ((task_t *)(msg->data))->fn;
+            task->scheduled = false; // runs in ready queue order, bids go through bid_processing()
             if(msg->has_side_effects) // as per specs in google doc
                 task->type = PRIMARY_EXEC;
             else
                 task->type = SECONDARY_EXEC;
-            // create task description, and fill it with user data
-            task->desc = mco_desc_init((task->fn.fn), 0);
-            task->desc.user_data = msg->user_data;
+            void *user_data = msg->user_data;
             task->data_size = msg->ud_allocd;
-            // create task coroutine
-            mco_create(&(task->ctx), &(task->desc));
+            if (msg->args_size > 0) { // small arguments came inline, copy them into task_t
+                user_data = task_copy_args(task, msg->args, msg->args_size);
+                if (user_data == NULL) {
+                    tboard_err("msg_processor: Failed to copy %zu bytes of task arguments.\n", msg->args_size);
+                    task_free(t, task);
+                    return false;
+                }
+            }
+            // create task coroutine with a stack sized for its function, and fill it with user data
+            mco_result res = task_context_create(t, task, user_data);
+            if (res != MCO_SUCCESS) {
+                tboard_err("msg_processor: Failed to create coroutine: %s.\n", mco_result_description(res));
+                if (msg->args_size > 0 && task->data_size > 0)
+                    free(user_data); // our copy of inline arguments, MQTT frees msg->user_data
+                task_free(t, task);
+                return false;
+            }
             // try to add task to task board
             if (task_add(t, task) == true) {
                 return true; // task was added successfully, return true
@@ -36,11 +52,13 @@ bool msg_processor(tboard_t *t, msg_t *msg)
                 // unsuccessful, destroy allocated values and return false
                 tboard_err("msg_processor: We have reached maximum number of concurrent tasks (%d)\n",MAX_TASKS);
                 mco_destroy(task->ctx); // destroy context created
-                free(task); // free task allocated above
+                if (msg->args_size > 0 && task->data_size > 0)
+                    free(user_data); // our copy of inline arguments, MQTT frees msg->user_data
+                task_free(t, task); // return task allocated above to pool
                 return false;
             }
         
-        case TASK_SCHEDULE: // unimplemented in current milestones
+        case TASK_SCHEDULE: // primary bids are admitted by scheduler
             if (msg->subtype == PRIMARY_EXEC) {
                 return bid_processing(t, (bid_t *)(msg->data));
             } else {
@@ -60,11 +78,3 @@ bool data_processor(tboard_t *t, msg_t *msg)
     tboard_err("data_processor: Data Processor unimplemented.\n");
     return false;
 }
-
-bool bid_processing(tboard_t *t, bid_t *bid)
-{ 
-    // missing requirements
-    (void)t; (void)bid;
-    tboard_err("msg_processor: Primary scheduler unimplemented.\n");
-    return false;
-}
\ No newline at end of file
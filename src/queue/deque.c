@@ -0,0 +1,111 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "deque.h"
+#include "queue.h"
+
+static struct deque_array *deque_array_new(long size) {
+    struct deque_array *a = malloc(sizeof(struct deque_array) + size*sizeof(void *));
+    if(!a) {
+        queue_error();
+    }
+    a->size = size;
+    a->retired = NULL;
+    return a;
+}
+
+static struct deque_array *deque_grow(struct deque *d, struct deque_array *a, long top, long bottom) {
+    // only the owner grows the array, so copying [top, bottom) is safe. Thieves still
+    // holding the old array read the same values from it, so it is retired, not freed
+    struct deque_array *n = deque_array_new(2*a->size);
+    for (long i=top; i<bottom; i++)
+        atomic_store_explicit(&n->buffer[i % n->size], atomic_load_explicit(&a->buffer[i % a->size], memory_order_relaxed), memory_order_relaxed);
+    n->retired = a;
+    atomic_store_explicit(&d->array, n, memory_order_release);
+    return n;
+}
+
+void deque_init(struct deque *d, long size) {
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    atomic_init(&d->array, deque_array_new(size > 0 ? size : DEQUE_INITIAL_SIZE));
+}
+
+void deque_destroy(struct deque *d) {
+    struct deque_array *a = atomic_load(&d->array);
+    while (a != NULL) {
+        struct deque_array *retired = a->retired;
+        free(a);
+        a = retired;
+    }
+    atomic_store(&d->array, NULL);
+}
+
+void deque_relocate(struct deque *d) {
+    // a copy of the same size, written by the owner so its pages are local to the owner's
+    // NUMA node under the default first-touch policy
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    struct deque_array *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    struct deque_array *n = deque_array_new(a->size);
+    for (long i=0; i<n->size; i++)
+        atomic_init(&n->buffer[i], NULL);
+    for (long i=t; i<b; i++)
+        atomic_store_explicit(&n->buffer[i % n->size], atomic_load_explicit(&a->buffer[i % a->size], memory_order_relaxed), memory_order_relaxed);
+    n->retired = a; // thieves may still read it, so it is freed by deque_destroy(). Call once per deque
+    atomic_store_explicit(&d->array, n, memory_order_release);
+}
+
+void deque_push(struct deque *d, void *data) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    struct deque_array *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    if (b - t > a->size - 1)
+        a = deque_grow(d, a, t, b);
+    atomic_store_explicit(&a->buffer[b % a->size], data, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+void *deque_pop(struct deque *d) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    struct deque_array *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    void *data = NULL;
+    if (t <= b) {
+        data = atomic_load_explicit(&a->buffer[b % a->size], memory_order_relaxed);
+        if (t == b) { // last element, race against thieves for it
+            if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+                data = NULL;
+            atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        }
+    } else { // deque was empty
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return data;
+}
+
+void *deque_steal(struct deque *d) {
+    while (true) {
+        long t = atomic_load_explicit(&d->top, memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+        if (t >= b)
+            return NULL;
+        struct deque_array *a = atomic_load_explicit(&d->array, memory_order_acquire);
+        void *data = atomic_load_explicit(&a->buffer[t % a->size], memory_order_relaxed);
+        if (atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+            return data;
+        // lost the race to another thief or the owner, try again
+    }
+}
+
+long deque_size(struct deque *d) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    return (b > t) ? b - t : 0;
+}
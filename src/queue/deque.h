@@ -0,0 +1,47 @@
+#ifndef TBOARD_DEQUE
+#define TBOARD_DEQUE
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+/**
+ * Chase-Lev work-stealing deque, following "Correct and Efficient Work-Stealing
+ * for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli, PPoPP'13).
+ *
+ * Only the owning thread may call deque_push() and deque_pop(). Any thread may
+ * call deque_steal(), including the owner. No operation takes a lock.
+ *
+ * The backing array doubles when full. Retired arrays are kept until
+ * deque_destroy() since a concurrent thief may still be reading from them.
+ */
+
+#define DEQUE_INITIAL_SIZE 256
+
+struct deque_array {
+    long size;
+    struct deque_array *retired;
+    _Atomic(void *) buffer[];
+};
+
+struct deque {
+    atomic_long top;
+    atomic_long bottom;
+    _Atomic(struct deque_array *) array;
+};
+
+void deque_init(struct deque *d, long size);
+
+void deque_destroy(struct deque *d);
+
+// owner only: move backing array to memory allocated (and first touched) by the calling thread
+void deque_relocate(struct deque *d);
+
+void deque_push(struct deque *d, void *data);
+
+void *deque_pop(struct deque *d);
+
+void *deque_steal(struct deque *d);
+
+long deque_size(struct deque *d);
+
+#endif
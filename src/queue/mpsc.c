@@ -0,0 +1,91 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "mpsc.h"
+
+void mpsc_init(struct mpsc_queue *q) {
+    atomic_init(&q->stub.next, NULL);
+    q->stub.data = NULL;
+    atomic_init(&q->head, &q->stub);
+    q->tail = &q->stub;
+    atomic_init(&q->consumer, false);
+}
+
+static void mpsc_link(struct mpsc_queue *q, struct mpsc_node *n) {
+    atomic_store_explicit(&n->next, NULL, memory_order_relaxed);
+    struct mpsc_node *prev = atomic_exchange_explicit(&q->head, n, memory_order_acq_rel);
+    // between the exchange and this store the queue is briefly disconnected, see mpsc_pop()
+    atomic_store_explicit(&prev->next, n, memory_order_release);
+}
+
+void mpsc_push(struct mpsc_queue *q, struct mpsc_node *n, void *data) {
+    n->data = data;
+    mpsc_link(q, n);
+}
+
+void mpsc_chain_init(struct mpsc_chain *c) {
+    c->first = NULL;
+    c->last = NULL;
+}
+
+void mpsc_chain_add(struct mpsc_chain *c, struct mpsc_node *n, void *data) {
+    // chain is private to the caller until pushed, so plain stores suffice
+    n->data = data;
+    atomic_store_explicit(&n->next, NULL, memory_order_relaxed);
+    if (c->last != NULL)
+        atomic_store_explicit(&c->last->next, n, memory_order_relaxed);
+    else
+        c->first = n;
+    c->last = n;
+}
+
+void mpsc_push_chain(struct mpsc_queue *q, struct mpsc_chain *c) {
+    if (c->first == NULL)
+        return;
+    // publish whole chain at once, the release store below orders the links made in mpsc_chain_add()
+    struct mpsc_node *prev = atomic_exchange_explicit(&q->head, c->last, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, c->first, memory_order_release);
+    mpsc_chain_init(c);
+}
+
+struct mpsc_node *mpsc_pop(struct mpsc_queue *q) {
+    struct mpsc_node *tail = q->tail;
+    struct mpsc_node *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (tail == &q->stub) { // skip over stub
+        if (next == NULL)
+            return NULL;
+        q->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+    // tail is the last linked node. If a producer has swapped head but not linked yet, wait for it
+    if (tail != atomic_load_explicit(&q->head, memory_order_acquire))
+        return NULL;
+    // put stub back behind tail so tail can be handed out
+    mpsc_link(q, &q->stub);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+bool mpsc_empty(struct mpsc_queue *q) {
+    return q->tail == &q->stub && atomic_load_explicit(&q->stub.next, memory_order_acquire) == NULL
+        && atomic_load_explicit(&q->head, memory_order_acquire) == &q->stub;
+}
+
+bool mpsc_try_acquire(struct mpsc_queue *q) {
+    if (atomic_load_explicit(&q->consumer, memory_order_relaxed))
+        return false;
+    return !atomic_exchange_explicit(&q->consumer, true, memory_order_acquire);
+}
+
+void mpsc_release(struct mpsc_queue *q) {
+    atomic_store_explicit(&q->consumer, false, memory_order_release);
+}
@@ -0,0 +1,61 @@
+#ifndef TBOARD_MPSC
+#define TBOARD_MPSC
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/**
+ * Intrusive multi-producer single-consumer queue, after Dmitry Vyukov's
+ * non-intrusive/intrusive MPSC node-based queue.
+ *
+ * Any thread may call mpsc_push(), which is wait-free (one atomic exchange).
+ * Consuming calls (mpsc_pop(), mpsc_empty()) must only be made by the thread
+ * currently holding the consumer role, taken with mpsc_try_acquire() and given
+ * back with mpsc_release(). Acquiring never blocks, so a consumer that loses
+ * the race simply moves on.
+ *
+ * Several nodes can be linked into a struct mpsc_chain first and then pushed
+ * with a single atomic exchange by mpsc_push_chain().
+ *
+ * Nodes are embedded in the queued object, nothing is allocated or freed.
+ * mpsc_pop() may return NULL while a producer is halfway through mpsc_push();
+ * the node becomes visible once that push completes.
+ */
+
+struct mpsc_node {
+    _Atomic(struct mpsc_node *) next;
+    void *data;
+};
+
+struct mpsc_queue {
+    _Atomic(struct mpsc_node *) head; // producers append here
+    struct mpsc_node *tail; // consumer pops here
+    struct mpsc_node stub;
+    atomic_bool consumer;
+};
+
+struct mpsc_chain {
+    struct mpsc_node *first;
+    struct mpsc_node *last;
+};
+
+void mpsc_init(struct mpsc_queue *q);
+
+void mpsc_chain_init(struct mpsc_chain *c);
+
+void mpsc_chain_add(struct mpsc_chain *c, struct mpsc_node *n, void *data);
+
+void mpsc_push_chain(struct mpsc_queue *q, struct mpsc_chain *c);
+
+void mpsc_push(struct mpsc_queue *q, struct mpsc_node *n, void *data);
+
+struct mpsc_node *mpsc_pop(struct mpsc_queue *q);
+
+bool mpsc_empty(struct mpsc_queue *q);
+
+bool mpsc_try_acquire(struct mpsc_queue *q);
+
+void mpsc_release(struct mpsc_queue *q);
+
+#endif
@@ -34,6 +34,13 @@ struct queue_entry *queue_new_node(void *data) {
     return entry;
 }
 
+// intrusive mode: initialize a queue_entry embedded in the object being queued, so
+// insertion does not allocate and a popped entry must not be freed
+struct queue_entry *queue_init_node(struct queue_entry *e, void *data) {
+    e->data = data;
+    return e;
+}
+
 void queue_insert_head(struct queue *q, struct queue_entry *e) {
     STAILQ_INSERT_HEAD(q, e, entries);
 }
@@ -53,3 +60,16 @@ struct queue_entry *queue_pop_head(struct queue *q) {
     }
     return elem;
 }
+
+// remove entry following @prev, or head if @prev is NULL, without walking the queue
+struct queue_entry *queue_remove_next(struct queue *q, struct queue_entry *prev) {
+    if (prev == NULL)
+        return queue_pop_head(q);
+    struct queue_entry *elem = STAILQ_NEXT(prev, entries);
+    if (elem) {
+        STAILQ_NEXT(prev, entries) = STAILQ_NEXT(elem, entries);
+        if (STAILQ_NEXT(prev, entries) == NULL) // removed tail
+            q->stqh_last = &STAILQ_NEXT(prev, entries);
+    }
+    return elem;
+}
@@ -20,6 +20,8 @@ void queue_init(struct queue *q);
 void queue_error();
 
 struct queue_entry *queue_new_node(void *data);
+
+struct queue_entry *queue_init_node(struct queue_entry *e, void *data);
 void queue_insert_head(struct queue *q, struct queue_entry *e);
 
 void queue_insert_tail(struct queue *q, struct queue_entry *e);
@@ -28,4 +30,6 @@ struct queue_entry *queue_peek_front(struct queue *q) ;
 
 struct queue_entry *queue_pop_head(struct queue *q);
 
+struct queue_entry *queue_remove_next(struct queue *q, struct queue_entry *prev);
+
 #endif
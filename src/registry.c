@@ -0,0 +1,206 @@
+/**
+ * Contains all functions pertaining to the task registry
+ *
+ * Every task added to the task board is assigned a unique 64-bit ID and kept in the registry
+ * until it terminates, so it can be found by ID in constant time. IDs are handed out from
+ * blocks of ID_BLOCK_SIZE each thread claims from a process-wide counter, and are only turned
+ * into uuid4 strings when they leave the task board (see task_id_to_uuid()). The registry is split into
+ * REGISTRY_SHARDS hash tables, each behind its own lock, and task @id lives in shard
+ * @id % REGISTRY_SHARDS. Consecutive IDs land in different shards, so threads adding and
+ * terminating tasks rarely contend. Hash handles are embedded in task_t, so adding a task
+ * does not allocate.
+ *
+ * Cancelling a task sets its @cancelled flag, under the lock of its shard. A task asleep in the
+ * timer wheel is unlinked and released right away. A task waiting on a blocking remote task
+ * is released right away too, except for its context, which the remote task may still write
+ * to: its remote task is marked abandoned, and the context goes once the response arrives.
+ * Any other task is released by whichever executor takes it out of a ready queue next (see
+ * registry_discard()). A task is removed from its shard before it is released, so task_cancel()
+ * never touches a released task.
+ */
+#include "tboard.h"
+#include "registry.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <assert.h>
+#include <minicoro.h>
+
+#define UUID_VERSION_MASK 0xf000ULL // version nibble, third group of uuid string
+#define UUID_VERSION 0x4000ULL
+#define UUID_VARIANT_SHIFT 62 // variant bits, fourth group of uuid string
+#define UUID_VARIANT 0x2ULL
+#define UUID_ID_MASK ((1ULL << UUID_VARIANT_SHIFT) - 1)
+
+static _Atomic uint64_t id_blocks = 0; // blocks claimed by all threads of all task boards
+static _Thread_local uint64_t id_next = 0, id_end = 0; // rest of calling thread's block
+
+
+void registry_init(tboard_t *t)
+{
+    for (int i=0; i<REGISTRY_SHARDS; i++) {
+        assert(pthread_mutex_init(&(t->reg_mutex[i]), NULL) == 0);
+        t->registry[i] = NULL;
+    }
+    atomic_init(&(t->reg_cancelled), 0);
+
+    // random first half of uuid strings, so those of different task boards do not collide
+    struct timespec mono, real;
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    clock_gettime(CLOCK_REALTIME, &real);
+    uint64_t seed = (uint64_t)real.tv_sec * 1000000000ULL + real.tv_nsec;
+    seed ^= ((uint64_t)mono.tv_sec * 1000000000ULL + mono.tv_nsec) << 17;
+    seed ^= (uint64_t)(uintptr_t)t;
+    // splitmix64 finalizer spreads the entropy of seed over all bits
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+    seed ^= seed >> 31;
+    t->uuid_node = (seed & ~UUID_VERSION_MASK) | UUID_VERSION;
+}
+
+void registry_destroy(tboard_t *t)
+{
+    // executors are joined. Tasks still registered are destroyed by tboard_destroy() afterwards
+    for (int i=0; i<REGISTRY_SHARDS; i++) {
+        pthread_mutex_lock(&(t->reg_mutex[i]));
+        HASH_CLEAR(rh, t->registry[i]);
+        pthread_mutex_unlock(&(t->reg_mutex[i]));
+        pthread_mutex_destroy(&(t->reg_mutex[i]));
+    }
+}
+
+uint64_t registry_next_id()
+{
+    if (id_next == id_end) { // block used up, claim another
+        id_next = atomic_fetch_add_explicit(&id_blocks, 1, memory_order_relaxed) * ID_BLOCK_SIZE;
+        id_end = id_next + ID_BLOCK_SIZE;
+        if (id_next == 0) // 0 marks unregistered tasks
+            id_next++;
+    }
+    return id_next++;
+}
+
+void registry_add(tboard_t *t, task_t *task)
+{
+    if (task->id == 0)
+        task->id = registry_next_id();
+    atomic_store_explicit(&(task->cancelled), false, memory_order_relaxed);
+    int shard = task->id % REGISTRY_SHARDS;
+    pthread_mutex_lock(&(t->reg_mutex[shard]));
+    HASH_ADD(rh, t->registry[shard], id, sizeof(uint64_t), task);
+    pthread_mutex_unlock(&(t->reg_mutex[shard]));
+}
+
+void registry_remove(tboard_t *t, task_t *task)
+{
+    if (task->id == 0) // blocking child tasks are not registered
+        return;
+    int shard = task->id % REGISTRY_SHARDS;
+    pthread_mutex_lock(&(t->reg_mutex[shard]));
+    HASH_DELETE(rh, t->registry[shard], task);
+    pthread_mutex_unlock(&(t->reg_mutex[shard]));
+}
+
+void registry_detach(tboard_t *t, task_t *task)
+{
+    registry_remove(t, task);
+    if (task->futures != NULL) // children we spawned free their futures
+        future_abandon(task);
+    if (task->future != NULL) // parent joining us must not wait forever
+        future_complete(t, task->future, false);
+    task->future = NULL;
+    tboard_deinc_concurrent(t);
+    atomic_fetch_add_explicit(&(t->reg_cancelled), 1, memory_order_relaxed);
+}
+
+void registry_free(tboard_t *t, task_t *task)
+{
+    if (task->data_size > 0 && task->desc.user_data != NULL)
+        free(task->desc.user_data);
+    mco_destroy(task->ctx);
+    task_free(t, task);
+}
+
+void registry_discard(tboard_t *t, task_t *task)
+{
+    registry_detach(t, task);
+    registry_free(t, task);
+}
+
+bool task_cancel(tboard_t *t, uint64_t id)
+{
+    if (t == NULL || id == 0)
+        return false;
+    task_t *task = NULL;
+    bool cancelled = false, asleep = false, abandoned = false;
+    int shard = id % REGISTRY_SHARDS;
+    // shard lock keeps task from being released while we flag it
+    pthread_mutex_lock(&(t->reg_mutex[shard]));
+    HASH_FIND(rh, t->registry[shard], &id, sizeof(uint64_t), task);
+    if (task != NULL)
+        cancelled = !atomic_exchange_explicit(&(task->cancelled), true, memory_order_seq_cst);
+    if (cancelled) {
+        // timer_add() and remote_task_place() check flag under the lock we look under, so a
+        // task on its way to sleep or wait is either found here or not left waiting
+        asleep = timer_remove(t, task);
+        if (!asleep) {
+            pthread_mutex_lock(&(t->msg_mutex));
+            if (task->remote != NULL) { // response releases context, see handle_msg_recv()
+                task->remote->abandoned = true;
+                task->remote = NULL;
+                abandoned = true;
+            }
+            pthread_mutex_unlock(&(t->msg_mutex));
+        }
+    }
+    pthread_mutex_unlock(&(t->reg_mutex[shard]));
+
+    // nothing else holds task now, release it without waiting for an executor
+    if (asleep)
+        registry_discard(t, task);
+    else if (abandoned)
+        registry_detach(t, task);
+    return cancelled;
+}
+
+void task_id_to_uuid(tboard_t *t, uint64_t id, char *dst)
+{
+    uint64_t lo = (UUID_VARIANT << UUID_VARIANT_SHIFT) | (id & UUID_ID_MASK);
+    snprintf(dst, UUID4_LEN, "%08" PRIx64 "-%04" PRIx64 "-%04" PRIx64 "-%04" PRIx64 "-%012" PRIx64,
+        t->uuid_node >> 32, (t->uuid_node >> 16) & 0xffff, t->uuid_node & 0xffff,
+        lo >> 48, (uint64_t)(lo & 0xffffffffffffULL));
+}
+
+uint64_t task_id_from_uuid(tboard_t *t, const char *uuid)
+{
+    if (t == NULL || uuid == NULL)
+        return 0;
+    uint64_t half[2] = {0, 0};
+    int digits = 0;
+    for (int i=0; i<UUID4_LEN-1; i++) {
+        char c = uuid[i];
+        if (i == 8 || i == 13 || i == 18 || i == 23) { // group separators
+            if (c != '-')
+                return 0;
+            continue;
+        }
+        int v;
+        if (c >= '0' && c <= '9')
+            v = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            v = c - 'A' + 10;
+        else
+            return 0; // also catches strings that end early
+        half[digits / 16] = (half[digits / 16] << 4) | v;
+        digits++;
+    }
+    if (uuid[UUID4_LEN-1] != '\0' || half[0] != t->uuid_node || (half[1] >> UUID_VARIANT_SHIFT) != UUID_VARIANT)
+        return 0; // not one of ours
+    return half[1] & UUID_ID_MASK;
+}
@@ -0,0 +1,6 @@
+#ifndef __REGISTRY_H_
+#define __REGISTRY_H_
+/**
+ * Task registry of task board, prototypes are found in tboard.h
+ */
+#endif
@@ -1,8 +1,325 @@
 /**
  * Contains all functions pertaining to the task board scheduler
- * 
- * Since this is not yet implemented into the task board in milestone 1-2,
- * this file is empty.
+ *
+ * The primary scheduler admits bids issued remotely (see bid_processing()) and orders
+ * the resulting primary tasks by earliest deadline first. A bid carries the earliest
+ * start time (EST) and latest start time (LST) of its task, both in milliseconds since
+ * the task board was created (see scheduler_time()). A task is due once its EST has
+ * arrived, and meets its deadline if it starts running no later than its LST.
+ *
+ * Admitted tasks are pushed to the lock-free @t->sched_inbox by whichever thread admits
+ * them. pExecutor moves them into @t->sched_heap, a binary min-heap keyed by LST that
+ * only pExecutor accesses, and always runs a due scheduled task before anything in the
+ * primary ready queue. Tasks whose LST has passed are rejected on admission, and dropped
+ * without running if their LST passes while they wait.
+ *
+ * Secondary tasks may optionally be scheduled by multi-level feedback queues (see
+ * tboard_set_mlfq()). Level 0 is the work-stealing deque of each sExecutor, where new tasks
+ * land. Tasks that use up the CPU time allotment of their level without completing are
+ * demoted to lower levels, which are plain queues only their sExecutor accesses and runs once
+ * level 0 is empty. Tasks whose function usually completes quickly, according to its execution
+ * history, are promoted again after a short slice, and every MLFQ_BOOST_INTERVAL ms all tasks
+ * are moved back to level 0 so demoted tasks cannot starve.
  */
 #include "tboard.h"
-#include "scheduler.h"
\ No newline at end of file
+#include "scheduler.h"
+#include "queue/queue.h"
+#include "queue/deque.h"
+#include "queue/mpsc.h"
+
+#include <stdlib.h>
+#include <time.h>
+#include <minicoro.h>
+
+#define SCHED_HEAP_INITIAL_SIZE 64
+
+
+void scheduler_init(tboard_t *t)
+{
+    clock_gettime(CLOCK_MONOTONIC, &(t->sched_epoch));
+    mpsc_init(&(t->sched_inbox));
+    t->sched_heap = NULL;
+    t->sched_len = 0;
+    t->sched_cap = 0;
+    atomic_init(&(t->sched_admitted), 0);
+    atomic_init(&(t->sched_rejected), 0);
+    atomic_init(&(t->sched_hits), 0);
+    atomic_init(&(t->sched_misses), 0);
+}
+
+void scheduler_destroy(tboard_t *t)
+{
+    // executors are joined, so we may consume the inbox as if we were pExecutor
+    struct mpsc_node *node;
+    while ((node = mpsc_pop(&(t->sched_inbox))) != NULL)
+        task_destroy((task_t *)(node->data));
+    for (int i=0; i<t->sched_len; i++)
+        task_destroy(t->sched_heap[i]);
+    free(t->sched_heap);
+    t->sched_heap = NULL;
+    t->sched_len = t->sched_cap = 0;
+}
+
+int scheduler_time(tboard_t *t)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int)((now.tv_sec - t->sched_epoch.tv_sec) * 1000
+               + (now.tv_nsec - t->sched_epoch.tv_nsec) / 1000000);
+}
+
+static void sched_heap_push(tboard_t *t, task_t *task)
+{
+    if (t->sched_len == t->sched_cap) {
+        t->sched_cap = (t->sched_cap == 0) ? SCHED_HEAP_INITIAL_SIZE : 2 * t->sched_cap;
+        t->sched_heap = realloc(t->sched_heap, t->sched_cap * sizeof(task_t *));
+        if (t->sched_heap == NULL) {
+            tboard_err("scheduler: Unable to grow deadline heap to %d tasks.\n", t->sched_cap);
+            exit(EXIT_FAILURE);
+        }
+    }
+    // sift up from the new leaf
+    int i = t->sched_len++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (t->sched_heap[parent]->lst <= task->lst)
+            break;
+        t->sched_heap[i] = t->sched_heap[parent];
+        i = parent;
+    }
+    t->sched_heap[i] = task;
+}
+
+static task_t *sched_heap_pop(tboard_t *t)
+{
+    task_t *top = t->sched_heap[0];
+    task_t *last = t->sched_heap[--(t->sched_len)];
+    // sift the last leaf down from the root
+    int i = 0;
+    while (true) {
+        int child = 2 * i + 1;
+        if (child >= t->sched_len)
+            break;
+        if (child + 1 < t->sched_len && t->sched_heap[child + 1]->lst < t->sched_heap[child]->lst)
+            child++;
+        if (last->lst <= t->sched_heap[child]->lst)
+            break;
+        t->sched_heap[i] = t->sched_heap[child];
+        i = child;
+    }
+    if (t->sched_len > 0)
+        t->sched_heap[i] = last;
+    return top;
+}
+
+static void scheduler_drain_inbox(tboard_t *t)
+{
+    struct mpsc_node *node;
+    for (int i=0; i<INBOX_BATCH && (node = mpsc_pop(&(t->sched_inbox))) != NULL; i++)
+        sched_heap_push(t, (task_t *)(node->data));
+}
+
+static void scheduler_drop(tboard_t *t, task_t *task)
+{
+    // task missed its deadline before it ever ran, so nothing but us references it
+    registry_remove(t, task);
+    if (task->data_size > 0 && task->desc.user_data != NULL)
+        free(task->desc.user_data);
+    mco_destroy(task->ctx);
+    task_free(t, task);
+    tboard_deinc_concurrent(t);
+}
+
+task_t *scheduler_next(tboard_t *t)
+{
+    scheduler_drain_inbox(t);
+    if (t->sched_len == 0)
+        return NULL;
+    int now = scheduler_time(t);
+    while (t->sched_len > 0) {
+        task_t *top = t->sched_heap[0];
+        if (top->status == TASK_INITIALIZED && top->lst < now) {
+            // latest start time passed while waiting, running it now would be of no use
+            sched_heap_pop(t);
+            atomic_fetch_add_explicit(&(t->sched_misses), 1, memory_order_relaxed);
+            if (DEBUG)
+                tboard_log("scheduler: Task '%s' missed its deadline (LST %d, now %d).\n", top->fn.fn_name, top->lst, now);
+            scheduler_drop(t, top);
+            continue;
+        }
+        // earliest deadline is not due yet. Its EST may be later than that of the task after it,
+        // but running that one first could make us miss the earlier deadline
+        if (top->est > now)
+            return NULL;
+        sched_heap_pop(t);
+        if (top->status == TASK_INITIALIZED)
+            atomic_fetch_add_explicit(&(t->sched_hits), 1, memory_order_relaxed);
+        return top;
+    }
+    return NULL;
+}
+
+void scheduler_place(tboard_t *t, task_t *task)
+{
+    exec_t *self = executor_current(t);
+    if (self != NULL && self->type == PRIMARY_EXEC) { // only pExecutor accesses the heap
+        sched_heap_push(t, task);
+    } else {
+        mpsc_push(&(t->sched_inbox), &(task->inject), task);
+        executor_wake_primary(t);
+    }
+}
+
+int scheduler_wait(tboard_t *t)
+{
+    // only pExecutor calls this, so it may look at the heap
+    if (!mpsc_empty(&(t->sched_inbox)))
+        return 0;
+    if (t->sched_len == 0)
+        return -1;
+    int wait = t->sched_heap[0]->est - scheduler_time(t);
+    return (wait > 0) ? wait : 0;
+}
+
+void scheduler_print_stats(tboard_t *t, FILE *fptr)
+{
+    long hits = atomic_load(&(t->sched_hits)), misses = atomic_load(&(t->sched_misses));
+    fprintf(fptr, "Scheduler: %ld bids admitted, %ld rejected. %ld deadlines hit, %ld missed (%.2f%% hit rate)\n",
+        atomic_load(&(t->sched_admitted)), atomic_load(&(t->sched_rejected)), hits, misses,
+        (hits + misses > 0) ? 100.0 * hits / (hits + misses) : 0.0);
+}
+
+bool bid_processing(tboard_t *t, bid_t *bid)
+{
+    if (t == NULL || bid == NULL || bid->data == NULL)
+        return false;
+    if (bid->type != PRIMARY_EXEC && bid->type != PRIORITY_EXEC) {
+        tboard_err("bid_processing: Only primary tasks can be scheduled, got type %d.\n", bid->type);
+        return false;
+    }
+    int now = scheduler_time(t);
+    if (bid->LST < now || bid->EST > bid->LST) {
+        // reject early, the task could never start in time
+        atomic_fetch_add_explicit(&(t->sched_rejected), 1, memory_order_relaxed);
+        if (DEBUG)
+            tboard_log("bid_processing: Rejected bid with EST %d and LST %d at %d.\n", bid->EST, bid->LST, now);
+        return false;
+    }
+
+    // only function of bid->data is taken, it is owned by caller and its internal state is not ours
+    task_t *task = task_alloc(t); // zeroed, returned to pool by executor, or by scheduler if deadline is missed
+    if (task == NULL) {
+        tboard_err("bid_processing: Failed to allocate task.\n");
+        return false;
+    }
+    task->status = TASK_INITIALIZED;
+    task->type = bid->type;
+    task->id = 0; // assigned by task_add()
+    task->fn = ((task_t *)(bid->data))->fn;
+    task->est = bid->EST;
+    task->lst = bid->LST;
+    task->scheduled = true; // task_place() hands it to scheduler_place()
+    task->data_size = bid->ud_allocd;
+    mco_result res = task_context_create(t, task, bid->user_data);
+    if (res != MCO_SUCCESS) {
+        tboard_err("bid_processing: Failed to create coroutine: %s.\n", mco_result_description(res));
+        task_free(t, task);
+        return false;
+    }
+    if (task_add(t, task) == false) {
+        tboard_err("bid_processing: We have reached maximum number of concurrent tasks (%d)\n",MAX_TASKS);
+        mco_destroy(task->ctx);
+        task_free(t, task);
+        return false;
+    }
+    atomic_fetch_add_explicit(&(t->sched_admitted), 1, memory_order_relaxed);
+    return true;
+}
+
+
+//////////////////////////////////////////////////
+/////// Secondary multi-level feedback queues ////
+//////////////////////////////////////////////////
+
+static int mlfq_allotment(int level)
+{
+    // CPU time a task may use at @level before it is demoted, doubling at each level
+    return MLFQ_QUANTUM << level;
+}
+
+void mlfq_feedback(tboard_t *t, task_t *task, int slice, exec_t *exec)
+{
+    if (!t->mlfq)
+        return;
+    task->level_time += slice;
+    if (task->level < MLFQ_LEVELS - 1 && task->level_time > mlfq_allotment(task->level)) {
+        // used up its allotment at this level and still has not completed
+        task->level++;
+        task->level_time = 0;
+        exec->mlfq_demotions++;
+    } else if (task->level > 0 && slice < MLFQ_QUANTUM && task->hist != NULL && task->hist->completions > 0
+               && task->hist->mean_t < mlfq_allotment(task->level - 1)) {
+        // short slice, and tasks of this function usually complete within allotment of level above.
+        // History is read without locking @t->hmutex, so this is only an estimate
+        task->level--;
+        task->level_time = 0;
+        exec->mlfq_promotions++;
+    }
+}
+
+void mlfq_place(tboard_t *t, int num, task_t *task)
+{
+    if (task->level == 0)
+        deque_push(&(t->sdeque[num]), task);
+    else
+        queue_insert_tail(&(t->smlfq[num][task->level - 1]), queue_init_node(&(task->entry), task));
+}
+
+static void mlfq_boost(tboard_t *t, int num)
+{
+    // move every demoted task back to level 0, so CPU-heavy tasks cannot starve
+    for (int l=0; l<MLFQ_LEVELS-1; l++) {
+        struct queue_entry *entry;
+        while ((entry = queue_pop_head(&(t->smlfq[num][l]))) != NULL) {
+            task_t *task = (task_t *)(entry->data);
+            task->level = 0;
+            task->level_time = 0;
+            deque_push(&(t->sdeque[num]), task);
+        }
+    }
+}
+
+void mlfq_age(tboard_t *t, int num, exec_t *exec)
+{
+    if (!t->mlfq)
+        return;
+    uint64_t now = timer_now();
+    if (now < t->mlfq_boost[num])
+        return;
+    if (t->mlfq_boost[num] != 0) { // first call only starts the clock
+        mlfq_boost(t, num);
+        exec->mlfq_boosts++;
+    }
+    t->mlfq_boost[num] = now + (uint64_t)MLFQ_BOOST_INTERVAL * 1000000;
+}
+
+task_t *mlfq_next(tboard_t *t, int num)
+{
+    // lower levels are only run once level 0 is empty, highest level first. Drained even if
+    // MLFQ was disabled in the meantime
+    for (int l=0; l<MLFQ_LEVELS-1; l++) {
+        struct queue_entry *entry = queue_pop_head(&(t->smlfq[num][l]));
+        if (entry != NULL)
+            return (task_t *)(entry->data);
+    }
+    return NULL;
+}
+
+bool mlfq_has_work(tboard_t *t, int num)
+{
+    for (int l=0; l<MLFQ_LEVELS-1; l++) {
+        if (queue_peek_front(&(t->smlfq[num][l])) != NULL)
+            return true;
+    }
+    return false;
+}
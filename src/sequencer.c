@@ -5,20 +5,18 @@
 
 void task_sequencer(tboard_t *tboard)
 {
-    // check if any remote tasks have returned
-    struct queue_entry *entry = queue_peek_front(&(tboard->msg_recv));
-    if (entry != NULL) { // we have found a remote task
+    // check if any remote tasks have returned, doorbell count is read without locking
+    if (atomic_load_explicit(&(tboard->msg_pending), memory_order_acquire) > 0) { // we have found a remote task
         pthread_mutex_lock(&(tboard->msg_mutex));
         // check if queue still has an element in it. It might not due to race condition as several
         // threads run this function
-        entry = queue_peek_front(&(tboard->msg_recv));
+        struct queue_entry *entry = queue_peek_front(&(tboard->msg_recv));
         if (entry != NULL) { // queue still has element in it!
             // enclose action so it is easier to add more sequencer functionality before
             queue_pop_head(&(tboard->msg_recv));
-            // handle remote task response
+            atomic_fetch_sub(&(tboard->msg_pending), 1);
+            // handle remote task response, which also releases remote_task_t
             handle_msg_recv(tboard, (remote_task_t *)(entry->data));
-            // free remote_task_t after handling
-            free(entry->data);
             // free queue entry
             free(entry);
         }
@@ -33,15 +31,23 @@ void handle_msg_recv(tboard_t *t, remote_task_t *rtask)
 {
     if(rtask == NULL)
         return;
-    if (rtask->blocking) {
-        // if task is blocking, push copy of rtask to parent task storage
-        assert(mco_push(rtask->calling_task->ctx, rtask, sizeof(remote_task_t)) == MCO_SUCCESS);
-        // place parent task back to appropriate queue
+    if (rtask->blocking && rtask->abandoned) {
+        // issuing task was cancelled while it waited, and released but for its context
+        registry_free(t, rtask->calling_task);
+        if (rtask->data_size > 0 && rtask->data != NULL)
+            free(rtask->data);
+        remote_task_free(t, rtask);
+    } else if (rtask->blocking) {
+        rtask->calling_task->remote = NULL;
+        // place parent task back to appropriate queue. remote_task_create() still holds rtask,
+        // reads its status and returns it to pool
         task_place(t, rtask->calling_task);
     } else {
         // non-blocking so we can destroy response/arguments
         if (rtask->data_size > 0 && rtask->data != NULL)
             free(rtask->data);
+        // return remote_task_t to pool after handling
+        remote_task_free(t, rtask);
     }
 }
 
@@ -54,43 +60,28 @@ void handle_msg_recv(tboard_t *t, remote_task_t *rtask)
  * continues this project afterwards may find it useful
  */
 
-// the following function removes a specific queue entry by id recursively and returns it
-struct queue_entry *remove_queue_entry_by_id(struct queue *q, int id)
+// the following function removes a specific queue entry by id and returns it. Walks the queue
+// once instead of recursing, so it does not run out of stack on a long queue. Tasks can be
+// found by id in constant time with the task registry instead (see task_cancel())
+struct queue_entry *remove_queue_entry_by_id(struct queue *q, uint64_t id)
 {
-    
-    struct queue_entry *head = queue_pop_head(q); // pop head
-    if (head == NULL) { // if NULL, then we reached end of queue without finding it
-        return NULL;
-    }
-    // if using uuid4 instead, function must call strcmp(task->id, id) == 0
-    if (((task_t *)(head->data))->id == id) { // if head matches id, return it without inserting it back
-        return head;
-    } else { // if head does not match id
-        struct queue_entry *ret = remove_queue_entry_by_id(q, id); // recursively run function to get matching entry
-        queue_insert_head(q, head); // reinsert non-matching head back into queue at the head
-        return ret; // return matching entry
+    struct queue_entry *prev = NULL;
+    for (struct queue_entry *entry = queue_peek_front(q); entry != NULL; entry = STAILQ_NEXT(entry, entries)) {
+        if (((task_t *)(entry->data))->id == id) // unlink matching entry from its predecessor
+            return queue_remove_next(q, prev);
+        prev = entry;
     }
+    return NULL; // reached end of queue without finding it
 }
 
-// the following function removes a specific queue entry by type recursively and returns it
+// the following function removes a specific queue entry by type and returns it
 struct queue_entry *remove_queue_entry_by_type(struct queue *q, int type)
 {
-    struct queue_entry *head = queue_pop_head(q); // pop head
-    if (head == NULL) { // if NULL, then we reached end of queue without finding it
-        return NULL;
-    }
-    if (((task_t *)(head->data))->type == type) { // if head matches id, return it without inserting it back
-        return head;
-    } else { // if head does not match id
-        struct queue_entry *ret = remove_queue_entry_by_type(q, type); // recursively run function to get matching entry
-        queue_insert_head(q, head); // reinsert non-matching head back into queue at the head
-        return ret; // return matching entry
+    struct queue_entry *prev = NULL;
+    for (struct queue_entry *entry = queue_peek_front(q); entry != NULL; entry = STAILQ_NEXT(entry, entries)) {
+        if (((task_t *)(entry->data))->type == type) // unlink matching entry from its predecessor
+            return queue_remove_next(q, prev);
+        prev = entry;
     }
+    return NULL; // reached end of queue without finding it
 }
-
-
-
-
-
-
-
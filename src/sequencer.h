@@ -4,7 +4,7 @@
 
 // helper functions for schedule implementation for whomever takes over
 
-struct queue_entry *remove_queue_entry_by_id(struct queue *q, int id);
+struct queue_entry *remove_queue_entry_by_id(struct queue *q, uint64_t id);
 /**
  * remove_queue_entry_by_id() - Removes first queue entry that matches id
  * @q:  queue to search through
@@ -13,6 +13,8 @@ struct queue_entry *remove_queue_entry_by_id(struct queue *q, int id);
  * Function will search for queue entry with entry->data->id == @id. If entry is found
  * it will be removed from the queue and returned, otherwise it will return NULL.
  * 
+ * Walks @q once, O(n) in its length. Use task_cancel() to stop a task by ID instead.
+ * 
  * Return: NULL        - no queue entry matching @id was found
  *         queue entry - first queue entry from head matching @id
  */
@@ -20,7 +22,7 @@ struct queue_entry *remove_queue_entry_by_id(struct queue *q, int id);
 
 struct queue_entry *remove_queue_entry_by_type(struct queue *q, int type);
 /**
- * remove_queue_entry_by_id() - Removes first queue entry that matches id
+ * remove_queue_entry_by_type() - Removes first queue entry that matches type
  * @q:    queue to search through
  * @type: type to match
  * 
@@ -38,7 +40,8 @@ void handle_msg_recv(tboard_t *t, remote_task_t *rtask);
  * @rtask: remote_task_t pointer to remote task response
  * 
  * Internal helper function takes remote task, handles status, frees variables
- * and places @rtask->calling_task in appropriate queue where applicable
+ * and places @rtask->calling_task in appropriate queue where applicable. Non-blocking @rtask is
+ * returned to @t->rtask_pool, blocking @rtask is left to the task that issued it
  * 
  * Context: None, but assumed to be run under @t->msg_mutex lock.
  */
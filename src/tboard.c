@@ -6,6 +6,7 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <string.h>
+#include <stdint.h>
 
 #define MINICORO_IMPL
 #define MINICORO_ASM
@@ -18,11 +19,33 @@
 
 #include <minicoro.h>
 #include "queue/queue.h"
+#include "queue/deque.h"
 
 ////////////////////////////////////////////
 //////////// TBOARD FUNCTIONS //////////////
 ////////////////////////////////////////////
 
+static void tboard_init_secondary(tboard_t *tboard, int i)
+{
+    // create & initialize secondary i's parker and queues
+    parker_init(&(tboard->sparker[i]));
+
+    deque_init(&(tboard->sdeque[i]), DEQUE_INITIAL_SIZE);
+
+    mpsc_init(&(tboard->sinbox[i]));
+
+    atomic_init(&(tboard->sidle[i]), 0);
+    atomic_init(&(tboard->sinbox_len[i]), 0);
+    atomic_init(&(tboard->sretire[i]), false);
+    atomic_init(&(tboard->squarantine[i]), false);
+    atomic_init(&(tboard->sstolen[i]), 0);
+    tboard->sstate[i] = SECONDARY_STOPPED;
+
+    for (int l=0; l<MLFQ_LEVELS-1; l++)
+        queue_init(&(tboard->smlfq[i][l]));
+    tboard->mlfq_boost[i] = 0;
+}
+
 tboard_t* tboard_create(int secondary_queues)
 {
     // create tboard
@@ -31,53 +54,74 @@ tboard_t* tboard_create(int secondary_queues)
     tboard_t *tboard = (tboard_t *)calloc(1, sizeof(tboard_t)); // allocate memory for tboard
                                                                 // free'd in tboard_destroy()
 
-    // assert that remote_task_t and task_t are different sizes. If they are the same size,
-    // then undefined behavior will occur when issuing blocking/remote tasks.
-    assert(sizeof(remote_task_t) != sizeof(task_t));
-
     // initiate primary queue's mutex and condition variables
-    assert(pthread_mutex_init(&(tboard->cmutex), NULL) == 0);
     assert(pthread_mutex_init(&(tboard->tmutex), NULL) == 0);
     assert(pthread_mutex_init(&(tboard->hmutex), NULL) == 0);
     assert(pthread_mutex_init(&(tboard->emutex), NULL) == 0);
     assert(pthread_mutex_init(&(tboard->msg_mutex), NULL) == 0);
+    assert(pthread_mutex_init(&(tboard->smutex), NULL) == 0);
+    assert(pthread_mutex_init(&(tboard->parallel_mutex), NULL) == 0);
     assert(pthread_cond_init(&(tboard->tcond), NULL) == 0);
     assert(pthread_cond_init(&(tboard->msg_cond), NULL) == 0);
 
     // create and initialize primary queues
-    assert(pthread_mutex_init(&(tboard->pmutex), NULL) == 0);
-    assert(pthread_cond_init(&(tboard->pcond), NULL) == 0);
+    parker_init(&(tboard->pparker));
+    atomic_init(&(tboard->pidle), 0);
 
     tboard->pqueue = queue_create();
 
     queue_init(&(tboard->pqueue));
 
-    // set number of secondaries tboard has
-    tboard->sqs = secondary_queues;
-
-    for (int i=0; i<secondary_queues; i++) {
-        // create & initialize secondary i's mutex, cond, queues
-        assert(pthread_mutex_init(&(tboard->smutex[i]), NULL)==0);
-        assert(pthread_cond_init(&(tboard->scond[i]), NULL) == 0);
-
-        tboard->squeue[i] = queue_create();
-
-        queue_init(&(tboard->squeue[i]));
-    }
+    mpsc_init(&(tboard->pinbox));
+
+    // set number of secondaries tboard has, more may be added later
+    atomic_init(&(tboard->sqs), secondary_queues);
+    atomic_init(&(tboard->smax), secondary_queues);
+
+    for (int i=0; i<secondary_queues; i++)
+        tboard_init_secondary(tboard, i);
+    tboard->autoscale = false;
+    tboard->slice_budget = 0;
+    tboard->slice_quarantine = false;
+    atomic_init(&(tboard->slice_overruns), 0);
+    atomic_init(&(tboard->idle_count), 0);
+    tboard->placement = DEFAULT_PLACEMENT;
+    tboard->mlfq = DEFAULT_MLFQ;
+    tboard->stack_profile = DEFAULT_STACK_PROFILE;
+    tboard->stack_sizing = DEFAULT_STACK_SIZING;
+    tboard->idle_spin = SPIN_BLOCK_ITERATIONS;
+    tboard->idle_yield = YIELD_BLOCK_ITERATIONS;
+    atomic_init(&(tboard->place_next), 0);
+
+    // initialize primary deadline scheduler, timer wheel and task registry
+    scheduler_init(tboard);
+    timer_init(tboard);
+    registry_init(tboard);
 
     // initialize remote message queues
     tboard->msg_sent = queue_create();
     tboard->msg_recv = queue_create();
     queue_init(&(tboard->msg_sent));
     queue_init(&(tboard->msg_recv));
+    atomic_init(&(tboard->msg_pending), 0);
 
 
 
     tboard->status = 0; // indicate its been created but not started
     tboard->shutdown = 0;
-    tboard->task_count = 0; // how many concurrent tasks are running
+    atomic_init(&(tboard->task_count), 0); // how many concurrent tasks are running
+    atomic_init(&(tboard->ext_adds), 0);
+    atomic_init(&(tboard->ext_ends), 0);
     tboard->exec_hist = NULL;
 
+    // initialize object pools, retaining at most as many objects as there can be tasks
+    pool_init(&(tboard->task_pool), sizeof(task_t), MAX_TASKS, POOL_CACHE_SIZE, true);
+    pool_init(&(tboard->rtask_pool), sizeof(remote_task_t), MAX_TASKS, POOL_CACHE_SIZE, true);
+    // coroutine contexts are large, so far fewer are retained. mco_init() resets them so no zeroing
+    for (int k=0; k<STACK_CLASSES; k++)
+        pool_init(&(tboard->stack_pool[k]), mco_desc_init(NULL, STACK_MIN_SIZE << k).coro_size,
+                  STACK_POOL_SIZE, STACK_CACHE_SIZE, false);
+
     return tboard; // return address of tboard in memory
 }
 
@@ -94,32 +138,46 @@ void tboard_start(tboard_t *tboard)
     primary->type = PRIMARY_EXEC;
     primary->num = 0;
     primary->tboard = tboard;
-    pthread_create(&(tboard->primary), NULL, executor, primary);
+    executor_spawn(tboard, &(tboard->primary), primary);
 
     // save it incase we call kill so we can free memory
     tboard->pexect = primary;
 
     // create secondary executors
+    pthread_mutex_lock(&(tboard->smutex));
     for (int i=0; i<tboard->sqs; i++) {
         exec_t *secondary = (exec_t *)calloc(1, sizeof(exec_t));
         secondary->type = SECONDARY_EXEC;
         secondary->num = i;
         secondary->tboard = tboard;
-        pthread_create(&(tboard->secondary[i]), NULL, executor, secondary);
         // save it incase we call kill so we can free memory
-        tboard->sexect[i] = secondary;
+        atomic_store_explicit(&(tboard->sexect[i]), secondary, memory_order_release);
+        executor_spawn(tboard, &(tboard->secondary[i]), secondary);
+        tboard->sstate[i] = SECONDARY_RUNNING;
     }
 
     tboard->status = 1; // started
+    pthread_mutex_unlock(&(tboard->smutex));
+
+    if (tboard->autoscale)
+        pthread_create(&(tboard->autoscaler), NULL, executor_autoscale, tboard);
+    if (tboard->slice_budget > 0)
+        pthread_create(&(tboard->watchdog), NULL, executor_watchdog, tboard);
 
 }
 
 void tboard_destroy(tboard_t *tboard)
 {
-    // wait for threads to terminate before destroying task board
+    // wait for threads to terminate before destroying task board. Autoscaler first, so number
+    // of sExecutors no longer changes
+    if (tboard->autoscale && tboard->status == 1)
+        pthread_join(tboard->autoscaler, NULL);
+    if (tboard->slice_budget > 0 && tboard->status == 1)
+        pthread_join(tboard->watchdog, NULL);
     pthread_join(tboard->primary, NULL);
-    for (int i=0; i<tboard->sqs; i++) {
-        pthread_join(tboard->secondary[i], NULL);
+    for (int i=0; i<tboard->smax; i++) {
+        if (tboard->sstate[i] != SECONDARY_STOPPED) // running until killed, or retired
+            pthread_join(tboard->secondary[i], NULL);
     }
     
     // broadcast that threads have all terminated to any thread sleeping on condition variable
@@ -132,31 +190,39 @@ void tboard_destroy(tboard_t *tboard)
     pthread_mutex_lock(&(tboard->tmutex));
 
     // destroy mutex and condition variables 
-    pthread_mutex_destroy(&(tboard->cmutex));
-    pthread_mutex_destroy(&(tboard->pmutex));
-    pthread_cond_destroy(&(tboard->pcond)); // broadcasted in tboard_kill()
-    for (int i=0; i<tboard->sqs; i++) {
-        pthread_mutex_destroy(&(tboard->smutex[i]));
-        pthread_cond_destroy(&(tboard->scond[i])); // broadcasted in tboard_kill();
-    }
+    parker_destroy(&(tboard->pparker)); // unparked in tboard_kill()
+    for (int i=0; i<tboard->smax; i++)
+        parker_destroy(&(tboard->sparker[i])); // unparked in tboard_kill()
     pthread_cond_destroy(&(tboard->tcond));
 
 
+    // release parallel loops whose root tasks are destroyed below, waking threads waiting on them
+    parallel_destroy(tboard);
+
+    // empty task registry first, its hash tables live in the tasks destroyed below
+    registry_destroy(tboard);
+
     // empty task queues and destroy any persisting contexts
-    for (int i=0; i<tboard->sqs; i++) {
-        struct queue_entry *entry = queue_peek_front(&(tboard->squeue[i]));
-        while (entry != NULL) {
-            queue_pop_head(&(tboard->squeue[i]));
-            task_destroy((task_t *)(entry->data)); // destroys task_t and coroutine
-            free(entry);
-            entry = queue_peek_front(&(tboard->squeue[i]));
-        }
+    // executors are joined, so we can consume injection queues and pop deques as if we were the owner
+    struct mpsc_node *node = NULL;
+    for (int i=0; i<tboard->smax; i++) {
+        while ((node = mpsc_pop(&(tboard->sinbox[i]))) != NULL)
+            task_destroy((task_t *)(node->data)); // destroys task_t and coroutine, including node
+        task_t *task = NULL;
+        while ((task = deque_pop(&(tboard->sdeque[i]))) != NULL)
+            task_destroy(task); // destroys task_t and coroutine
+        while ((task = mlfq_next(tboard, i)) != NULL)
+            task_destroy(task);
+        deque_destroy(&(tboard->sdeque[i]));
     }
+    while ((node = mpsc_pop(&(tboard->pinbox))) != NULL)
+        task_destroy((task_t *)(node->data));
+    scheduler_destroy(tboard);
+    timer_destroy(tboard);
     struct queue_entry *entry = queue_peek_front(&(tboard->pqueue));
     while (entry != NULL) {
         queue_pop_head(&(tboard->pqueue));
-        task_destroy((task_t *)(entry->data)); // destroys task_t and coroutine
-        free(entry);
+        task_destroy((task_t *)(entry->data)); // destroys task_t and coroutine, including entry
         entry = queue_peek_front(&(tboard->pqueue));
     }
 
@@ -186,11 +252,29 @@ void tboard_destroy(tboard_t *tboard)
     pthread_cond_broadcast(&(tboard->msg_cond)); // incase MQTT is waiting on this
     pthread_cond_destroy(&(tboard->msg_cond));
 
-    // free executor arguments
+    // free executor arguments, releasing objects cached by executors
+    if (tboard->pexect != NULL) {
+        pool_cache_destroy(&(tboard->pexect->task_cache));
+        pool_cache_destroy(&(tboard->pexect->rtask_cache));
+        for (int k=0; k<STACK_CLASSES; k++)
+            pool_cache_destroy(&(tboard->pexect->stack_cache[k]));
+    }
     free(tboard->pexect);
-    for (int i=0; i<tboard->sqs; i++) {
+    for (int i=0; i<tboard->smax; i++) {
+        if (tboard->sexect[i] != NULL) {
+            pool_cache_destroy(&(tboard->sexect[i]->task_cache));
+            pool_cache_destroy(&(tboard->sexect[i]->rtask_cache));
+            for (int k=0; k<STACK_CLASSES; k++)
+                pool_cache_destroy(&(tboard->sexect[i]->stack_cache[k]));
+        }
         free(tboard->sexect[i]);
     }
+
+    // destroy object pools
+    pool_destroy(&(tboard->task_pool));
+    pool_destroy(&(tboard->rtask_pool));
+    for (int k=0; k<STACK_CLASSES; k++)
+        pool_destroy(&(tboard->stack_pool[k]));
     
     // destroy history mutex
     history_destroy(tboard);
@@ -200,6 +284,8 @@ void tboard_destroy(tboard_t *tboard)
     pthread_mutex_destroy(&(tboard->tmutex));
     pthread_mutex_destroy(&(tboard->emutex));
     pthread_mutex_destroy(&(tboard->msg_mutex));
+    pthread_mutex_destroy(&(tboard->smutex));
+    pthread_mutex_destroy(&(tboard->parallel_mutex));
 
     // free task board object
     free(tboard);
@@ -212,22 +298,24 @@ bool tboard_kill(tboard_t *t)
     
     // lock emutex to before queueing executor thread cancellation
     pthread_mutex_lock(&(t->emutex));
+    // lock smutex so no sExecutor is added or retired while we cancel them
+    pthread_mutex_lock(&(t->smutex));
     // indicate to taskboard that shutdown is occuring
     t->shutdown = 1;
 
-    // queue primary executor thread cancellation, signal condition variable
-    pthread_mutex_lock(&(t->pmutex));
+    // queue primary executor thread cancellation, unpark it. Unparking leaves a permit
+    // should it not be parked yet, so it cannot park past shutdown
     pthread_cancel(t->primary);
-    pthread_cond_signal(&(t->pcond));
-    pthread_mutex_unlock(&(t->pmutex));
+    parker_unpark(&(t->pparker));
 
-    for (int i=0; i<t->sqs; i++) {
-        // queue secondary executor thread i cancellation, signal condition variable
-        pthread_mutex_lock(&(t->smutex[i]));
+    for (int i=0; i<t->smax; i++) {
+        // queue secondary executor thread i cancellation, unpark it. Retired ones exit by themselves
+        if (t->sstate[i] != SECONDARY_RUNNING)
+            continue;
         pthread_cancel(t->secondary[i]);
-        pthread_cond_signal(&(t->scond[i]));
-        pthread_mutex_unlock(&(t->smutex[i]));
+        parker_unpark(&(t->sparker[i]));
     }
+    pthread_mutex_unlock(&(t->smutex));
     
     // wait for executor threads to terminate fully
     pthread_cond_wait(&(t->tcond), &(t->emutex)); // will be signaled by tboard_destroy once threads exit
@@ -243,36 +331,72 @@ void tboard_exit()
 }
 
 
+static void concurrent_shard_add(tboard_t *t, long adds, long ends)
+{
+    exec_t *self = executor_current(t);
+    if (self == NULL) { // not an executor, use the shared shard
+        if (adds != 0) atomic_fetch_add_explicit(&(t->ext_adds), adds, memory_order_relaxed);
+        if (ends != 0) atomic_fetch_add_explicit(&(t->ext_ends), ends, memory_order_relaxed);
+        return;
+    }
+    // only the owning executor writes its shard, so a plain load and store suffice
+    if (adds != 0)
+        atomic_store_explicit(&(self->task_adds), atomic_load_explicit(&(self->task_adds), memory_order_relaxed) + adds, memory_order_relaxed);
+    if (ends != 0)
+        atomic_store_explicit(&(self->task_ends), atomic_load_explicit(&(self->task_ends), memory_order_relaxed) + ends, memory_order_relaxed);
+}
+
 int tboard_get_concurrent(tboard_t *t){
-    pthread_mutex_lock(&(t->cmutex));
-    int ret = t->task_count;
-    pthread_mutex_unlock(&(t->cmutex));
-    return ret;
+    return atomic_load(&(t->task_count));
+}
+
+int tboard_get_concurrent_approx(tboard_t *t){
+    long count = atomic_load_explicit(&(t->ext_adds), memory_order_relaxed)
+               - atomic_load_explicit(&(t->ext_ends), memory_order_relaxed);
+    for (int i=-1, smax=atomic_load_explicit(&(t->smax), memory_order_acquire); i<smax; i++) { // retired sExecutors keep their shards
+        exec_t *exec = (i < 0) ? t->pexect : atomic_load_explicit(&(t->sexect[i]), memory_order_acquire);
+        if (exec == NULL) // task board was not started
+            continue;
+        count += atomic_load_explicit(&(exec->task_adds), memory_order_relaxed)
+               - atomic_load_explicit(&(exec->task_ends), memory_order_relaxed);
+    }
+    return (count > 0) ? (int)count : 0;
 }
 
 void tboard_inc_concurrent(tboard_t *t){
-    pthread_mutex_lock(&(t->cmutex));
-    t->task_count++;
-    pthread_mutex_unlock(&(t->cmutex));
+    atomic_fetch_add(&(t->task_count), 1);
+    concurrent_shard_add(t, 1, 0);
+}
+
+int tboard_reserve_concurrent(tboard_t *t, int n){
+    // like tboard_add_concurrent(), but for up to n tasks in a single update
+    int count = atomic_load_explicit(&(t->task_count), memory_order_relaxed);
+    int ret;
+    do {
+        if (count >= MAX_TASKS || n <= 0)
+            return 0;
+        ret = (MAX_TASKS - count < n) ? MAX_TASKS - count : n;
+    } while (!atomic_compare_exchange_weak(&(t->task_count), &count, count + ret));
+    concurrent_shard_add(t, ret, 0);
+    return ret;
 }
 
 void tboard_deinc_concurrent(tboard_t *t){
-    pthread_mutex_lock(&(t->cmutex));
-    t->task_count--;
-    pthread_mutex_unlock(&(t->cmutex));
+    atomic_fetch_sub(&(t->task_count), 1);
+    concurrent_shard_add(t, 0, 1);
 }
 
 int tboard_add_concurrent(tboard_t *t){
     // non-zero value indicates we can add a new task
-    int ret = 0;
-    pthread_mutex_lock(&(t->cmutex));
-    if (DEBUG && t->task_count < 0)
-        tboard_log("tboard_add_concurrent: Invalid task_count encountered: %d\n",t->task_count);
-
-    if (t->task_count < MAX_TASKS)
-        ret = ++(t->task_count);
-    pthread_mutex_unlock(&(t->cmutex));
-    return ret;
+    int count = atomic_load_explicit(&(t->task_count), memory_order_relaxed);
+    if (DEBUG && count < 0)
+        tboard_log("tboard_add_concurrent: Invalid task_count encountered: %d\n",count);
+    do {
+        if (count >= MAX_TASKS)
+            return 0;
+    } while (!atomic_compare_exchange_weak(&(t->task_count), &count, count + 1)); // count reloaded on failure
+    concurrent_shard_add(t, 1, 0);
+    return count + 1;
 }
 
 
@@ -290,70 +414,67 @@ void remote_task_place(tboard_t *t, remote_task_t *rtask, bool send)
     pthread_mutex_lock(&(t->msg_mutex));
     struct queue_entry *entry = queue_new_node(rtask);
 
-    if (send) { // we want it in outgoing remote message queue
+    if (send && rtask->blocking && atomic_load(&(rtask->calling_task->cancelled))) {
+        // task_cancel() looked for us under msg_mutex already, issuing task goes to be discarded
+        task_place(t, rtask->calling_task);
+        if (rtask->data_size > 0 && rtask->data != NULL)
+            free(rtask->data);
+        remote_task_free(t, rtask);
+        free(entry);
+    } else if (send) { // we want it in outgoing remote message queue
+        if (rtask->blocking) // task_cancel() finds remote task through issuing task
+            rtask->calling_task->remote = rtask;
         queue_insert_tail(&(t->msg_sent), entry);
         pthread_cond_signal(&(t->msg_cond));
     } else { // we want it in incoming remote message queue
         queue_insert_tail(&(t->msg_recv), entry);
-        pthread_cond_signal(&(t->pcond)); // wake at least one executor so sequencer can run
+        // ring doorbell: any executor running TSeq picks the response up, and the issuing
+        // executor is woken so that one is sure to
+        atomic_fetch_add(&(t->msg_pending), 1);
+        executor_wake(t, rtask->issuer);
     }
     pthread_mutex_unlock(&(t->msg_mutex));
 }
 
 bool remote_task_create(tboard_t *t, char *message, void *args, size_t sizeof_args, bool blocking)
 {
-    (void)t;
     if (mco_running() == NULL) // must be called from a coroutine!
         return false;
 
-    mco_result res;
-
-    // create rtask object
-    remote_task_t rtask = {0};
-    rtask.status = TASK_INITIALIZED;
-    rtask.data = args;
-    rtask.data_size = sizeof_args;
-    rtask.blocking = blocking;
     int length = strlen(message);
     if(length > MAX_MSG_LENGTH){
         tboard_err("remote_task_create: Message length exceeds maximum supported value (%d > %d).\n",length, MAX_MSG_LENGTH);
         return false;
     }
-    // copy message to rtask object
-    memcpy(rtask.message, message, length);
-
-    // push rtask into storage. This copies memory in current thread so we dont have
-    // to worry about invalid reads
-    res = mco_push(mco_running(), &rtask, sizeof(remote_task_t));
-    if (res != MCO_SUCCESS) {
-        tboard_err("remote_task_create: Failed to push remote task to mco storage interface.\n");
+    // create rtask object, handed to executor as is. Returned to pool once response is handled
+    remote_task_t *rtask = remote_task_alloc(t);
+    if (rtask == NULL) {
+        tboard_err("remote_task_create: Failed to allocate remote task.\n");
         return false;
     }
-    // issued remote task, yield
-    task_yield();
+    rtask->status = TASK_INITIALIZED;
+    rtask->data = args;
+    rtask->data_size = sizeof_args;
+    rtask->blocking = blocking;
+    // copy message to rtask object
+    memcpy(rtask->message, message, length);
+
+    // issue remote task and yield. Unless blocking, rtask belongs to message queues from now on
+    executor_yield(YIELD_REMOTE, rtask, 0);
     // we have received control again of the task.
     if (!blocking) // if not blocking, return true and continue execution
         return true;
 
-    // blocking: get if remote_task_t is currently in storage. If so we must parse it
-    if (mco_get_bytes_stored(mco_running()) == sizeof(remote_task_t)) {
-        res = mco_pop(mco_running(), &rtask, sizeof(remote_task_t));
-        if (res != MCO_SUCCESS) {
-            tboard_err("remote_task_create: Failed to pop remote task from mco storage interface.\n");
-            return false;
-        }
-        // check if task completed
-        if (rtask.status == TASK_COMPLETED) {
-            return true;
-        } else {
-            tboard_err("remote_task_create: Blocking remote task is not marked as completed: %d.\n",rtask.status);
-            return false;
-        }
+    // blocking: we are only placed back once response is handled, and rtask is ours again
+    int status = rtask->status;
+    remote_task_free(t, rtask);
+    // check if task completed
+    if (status == TASK_COMPLETED) {
+        return true;
     } else {
-        tboard_err("remote_task_create: Failed to capture blocking remote task after termination.\n");
+        tboard_err("remote_task_create: Blocking remote task is not marked as completed: %d.\n",status);
         return false;
     }
-    
 }
 
 void remote_task_destroy(remote_task_t *rtask)
@@ -380,84 +501,334 @@ bool blocking_task_create(tboard_t *t, function_t fn, int type, void *args, size
     
     mco_result res;
 
-    // create task object
-    task_t task = {0};
-    task.status = TASK_INITIALIZED;
-    task.type = type; // tagged arbitrarily, will assume parents position
-    task.id = TASK_ID_BLOCKING;
-    task.fn = fn;
-    task.desc = mco_desc_init((task.fn.fn), 0);
-    task.desc.user_data = args;
-    task.data_size = sizeof_args;
-    task.parent = NULL;
-    task.hist = NULL;
-
-    // add task to history
-    history_record_exec(t, &task, &(task.hist));
-    task.hist->executions += 1; // increase execution count
-
-    // create coroutine context
-    if ( (res = mco_create(&(task.ctx), &(task.desc))) != MCO_SUCCESS ) {
+    // create task object, handed to executor as is. Returned to pool on termination
+    task_t *task = task_alloc(t);
+    if (task == NULL) {
+        tboard_err("blocking_task_create: Failed to allocate task.\n");
+        return false;
+    }
+    task->status = TASK_INITIALIZED;
+    task->type = type; // tagged arbitrarily, will assume parents position
+    task->id = 0; // takes the place of its parent, which keeps its ID
+    task->fn = fn;
+    task->data_size = sizeof_args;
+    task->parent = NULL;
+
+    // create coroutine context, which adds task to history
+    if ( (res = task_context_create(t, task, args)) != MCO_SUCCESS ) {
         tboard_err("blocking_task_create: Failed to create coroutine: %s.\n",mco_result_description(res));
+        task_free(t, task);
         return false;
-    } else { // context creation successful
-        // push task_t to storage
-        res = mco_push(mco_running(), &task, sizeof(task_t));
-        if (res != MCO_SUCCESS) {
-            tboard_err("blocking_task_create: Failed to push task to mco storage interface.\n");
+    }
+    task->hist->executions += 1; // increase execution count
+    // yield so executor can run blocking task
+    executor_yield(YIELD_CHILD, task, 0);
+    // we got control back, which only the executor that ran blocking task to completion
+    // does. Blocking task is back in pool by now, so must not be touched
+    return true;
+}
+
+void tboard_set_idle_policy(tboard_t *t, int spin_iterations, int yield_iterations)
+{
+    if (t == NULL)
+        return;
+    t->idle_spin = (spin_iterations > 0) ? spin_iterations : 0;
+    t->idle_yield = (yield_iterations > 0) ? yield_iterations : 0;
+}
+
+void tboard_set_placement(tboard_t *t, int policy)
+{
+    if (t == NULL)
+        return;
+    if (policy < PLACEMENT_POWER_OF_TWO || policy > PLACEMENT_LOCAL) {
+        tboard_err("tboard_set_placement: Unknown placement policy %d.\n", policy);
+        return;
+    }
+    t->placement = policy;
+}
+
+bool tboard_set_affinity(tboard_t *t, int type, int num, const int *cpus, int ncpus)
+{
+    if (t == NULL || t->status != 0 || ncpus < 0 || (ncpus > 0 && cpus == NULL))
+        return false;
+    if (type == SECONDARY_EXEC && (num < 0 || num >= MAX_SECONDARIES))
+        return false;
+#ifndef __linux__
+    tboard_err("tboard_set_affinity: Executor pinning is only supported on Linux.\n");
+    return false;
+#endif
+    uint64_t *mask = (type == PRIMARY_EXEC) ? t->paffinity : t->saffinity[num];
+    uint64_t set[AFFINITY_WORDS] = {0};
+    for (int i=0; i<ncpus; i++) {
+        if (cpus[i] < 0 || cpus[i] >= MAX_CPUS) {
+            tboard_err("tboard_set_affinity: CPU %d out of range (MAX_CPUS is %d).\n", cpus[i], MAX_CPUS);
             return false;
         }
-        // yield so executor can run blocking task
-        task_yield();
-        // we got control back meaning blocking task should have executed.
-        // check if task_t worth of memory is in storage
-        if (mco_get_bytes_stored(mco_running()) == sizeof(task_t)) {
-            // attempt to pop task_t from storage
-            res = mco_pop(mco_running(), &task, sizeof(task_t));
-            if (res != MCO_SUCCESS) {
-                tboard_err("blocking_task_create: Failed to pop task from mco storage interface.\n");
-                return false;
-            }
-            if (task.status == TASK_COMPLETED) { // task completed
-                return true;
-            } else {
-                tboard_err("blocking_task_create: Blocking task is not marked as completed: %d.\n", task.status);
-                return false;
-            }
-        } else {
-            tboard_err("blocking_task_create: Failed to capture blocking task after termination.\n");
-            return false;
+        set[cpus[i] / 64] |= 1ULL << (cpus[i] % 64);
+    }
+    memcpy(mask, set, sizeof(set));
+    return true;
+}
+
+int tboard_add_secondary(tboard_t *t)
+{
+    if (t == NULL)
+        return -1;
+    pthread_mutex_lock(&(t->smutex));
+    int num = t->sqs;
+    if (t->shutdown != 0 || num >= MAX_SECONDARIES) {
+        pthread_mutex_unlock(&(t->smutex));
+        return -1;
+    }
+    bool fresh = num >= t->smax; // first time this slot is used
+    if (fresh)
+        tboard_init_secondary(t, num);
+    if (t->sstate[num] == SECONDARY_RETIRED) { // previous sExecutor of this slot must be gone first
+        pthread_join(t->secondary[num], NULL);
+        t->sstate[num] = SECONDARY_STOPPED;
+    }
+    atomic_store(&(t->sretire[num]), false);
+    if (t->status == 1) {
+        exec_t *secondary = t->sexect[num];
+        if (secondary == NULL) {
+            secondary = (exec_t *)calloc(1, sizeof(exec_t)); // free'd in tboard_destroy()
+            secondary->type = SECONDARY_EXEC;
+            secondary->num = num;
+            secondary->tboard = t;
+            atomic_store_explicit(&(t->sexect[num]), secondary, memory_order_release);
         }
+        executor_spawn(t, &(t->secondary[num]), secondary);
+        t->sstate[num] = SECONDARY_RUNNING;
+    }
+    if (fresh) // slot is filled in, statistics and watchdog may look at it from now on
+        atomic_store_explicit(&(t->smax), num + 1, memory_order_release);
+    atomic_store(&(t->sqs), num + 1); // task placement may select it from now on
+    pthread_mutex_unlock(&(t->smutex));
+    return num;
+}
+
+bool tboard_remove_secondary(tboard_t *t)
+{
+    if (t == NULL)
+        return false;
+    pthread_mutex_lock(&(t->smutex));
+    int num = t->sqs - 1;
+    if (t->status != 1 || t->shutdown != 0 || num < 0) {
+        pthread_mutex_unlock(&(t->smutex));
+        return false;
+    }
+    // lower count before telling it to retire, see executor_inbox_reserve()
+    atomic_store(&(t->sqs), num);
+    atomic_store(&(t->sretire[num]), true);
+    t->sstate[num] = SECONDARY_RETIRED;
+    parker_unpark(&(t->sparker[num])); // leaves a permit should it not be parked yet
+    pthread_mutex_unlock(&(t->smutex));
+    return true;
+}
+
+bool tboard_set_watchdog(tboard_t *t, uint64_t budget, bool quarantine)
+{
+    if (t == NULL || t->status != 0)
+        return false;
+    t->slice_budget = budget;
+    t->slice_quarantine = quarantine;
+    return true;
+}
+
+bool tboard_set_autoscale(tboard_t *t, int min, int max)
+{
+    if (t == NULL || t->status != 0 || min < 1 || min > max || max > MAX_SECONDARIES)
+        return false;
+    t->autoscale = true;
+    t->scale_min = min;
+    t->scale_max = max;
+    t->scale_ups = 0;
+    t->scale_downs = 0;
+    return true;
+}
+
+void tboard_set_mlfq(tboard_t *t, bool enable)
+{
+    if (t == NULL)
+        return;
+    t->mlfq = enable;
+}
+
+void tboard_set_stack_profile(tboard_t *t, bool enable)
+{
+    if (t == NULL)
+        return;
+    t->stack_profile = enable;
+}
+
+void tboard_set_stack_sizing(tboard_t *t, bool enable)
+{
+    if (t == NULL)
+        return;
+    t->stack_sizing = enable;
+}
+
+static unsigned int place_random(void)
+{
+    // xorshift32 per thread, rand() serializes every caller on glibc's global lock
+    static _Thread_local unsigned int state = 0;
+    if (state == 0)
+        state = (unsigned int)(uintptr_t)&state | 1; // distinct nonzero seed per thread
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static long place_queue_len(tboard_t *t, int i, const long *pending)
+{
+    long len = deque_size(&(t->sdeque[i])) + atomic_load_explicit(&(t->sinbox_len[i]), memory_order_relaxed);
+    return (pending != NULL) ? len + pending[i] : len;
+}
+
+static int task_place_avoid(tboard_t *t, int j, int sqs)
+{
+    // first queue from j on whose sExecutor is not quarantined by watchdog, j if all are
+    for (int k=0; k<sqs; k++) {
+        int i = (j + k) % sqs;
+        if (!atomic_load_explicit(&(t->squarantine[i]), memory_order_relaxed))
+            return i;
     }
+    return j;
+}
+
+static int task_place_select(tboard_t *t, exec_t *self, const long *pending, int sqs)
+{
+    // @pending counts tasks of a batch already assigned to each queue but not yet placed.
+    // @sqs is the number of secondary queues loaded once by caller, as it may change meanwhile
+    if (sqs == 1)
+        return 0;
+    if (t->placement == PLACEMENT_ROUND_ROBIN)
+        return task_place_avoid(t, atomic_fetch_add_explicit(&(t->place_next), 1, memory_order_relaxed) % sqs, sqs);
+    if (t->placement == PLACEMENT_LOCAL && self != NULL && self->type == SECONDARY_EXEC && self->num < sqs)
+        return self->num;
+    // PLACEMENT_POWER_OF_TWO, also used by PLACEMENT_LOCAL when caller has no secondary queue
+    int a = place_random() % sqs;
+    int b = place_random() % (sqs - 1);
+    if (b >= a) // pick two distinct queues
+        b++;
+    if (atomic_load_explicit(&(t->squarantine[a]), memory_order_relaxed))
+        return task_place_avoid(t, b, sqs);
+    if (atomic_load_explicit(&(t->squarantine[b]), memory_order_relaxed))
+        return a;
+    return (place_queue_len(t, b, pending) < place_queue_len(t, a, pending)) ? b : a;
+}
+
+static void task_place_notify(tboard_t *t, int j)
+{
+    if (!executor_wake_secondary(t, j))
+        executor_wake_idle(t, j); // sExecutor j is busy, let an idle sibling steal it
 }
 
 void task_place(tboard_t *t, task_t *task)
 {
-    // add task to ready queue
-    if(task->type <= PRIMARY_EXEC || t->sqs == 0) {
-        // task should be added to primary ready queue
-        pthread_mutex_lock(&(t->pmutex)); // lock primary mutex
-        struct queue_entry *task_q = queue_new_node(task); // create queue entry
+    exec_t *self = executor_current(t);
+    if (task->scheduled) { // admitted by bid_processing(), runs in deadline order
+        scheduler_place(t, task);
+        return;
+    }
+    // add task to secondary ready queue, unless there are no sExecutors
+    int sqs;
+    while (task->type > PRIMARY_EXEC && (sqs = t->sqs) > 0) {
+        int j = task_place_select(t, self, NULL, sqs); // select secondary queue by placement policy
+
+        if (self != NULL && self->type == SECONDARY_EXEC && self->num == j) {
+            // we are sExecutor j, so we own its deque and can push without locking
+            mlfq_place(t, j, task); // its deque, unless task was demoted
+            executor_wake_idle(t, j); // let an idle sibling steal while we are busy
+        } else if (executor_inbox_reserve(t, j, 1)) { // counted so a sleeping sExecutor j sees it coming
+            mpsc_push(&(t->sinbox[j]), &(task->inject), task);
+            task_place_notify(t, j);
+        } else { // sExecutor j is retiring, select again
+            continue;
+        }
+        if (SIGNAL_PRIMARY_ON_NEW_SECONDARY_TASK == 1)
+            executor_wake_primary(t); // pExecutor may steal it
+        return;
+    }
+    // task should be added to primary ready queue
+    if (self != NULL && self->type == PRIMARY_EXEC) {
+        // we are pExecutor, the only thread accessing the primary ready queue
+        struct queue_entry *task_q = queue_init_node(&(task->entry), task); // use task's own queue entry
         if (task->type == PRIORITY_EXEC)
             queue_insert_head(&(t->pqueue), task_q); // insert queue entry to head
         else
             queue_insert_tail(&(t->pqueue), task_q); // insert queue entry to tail
-        pthread_cond_signal(&(t->pcond)); // signal primary condition variable as only one 
-                                          // thread will ever wait for pcond
-        pthread_mutex_unlock(&(t->pmutex)); // unlock mutex
     } else {
-        // task should be added to secondary ready queue
-        int j = rand() % (t->sqs); // randomly select secondary queue
-        
-        pthread_mutex_lock(&(t->smutex[j])); // lock secondary mutex
-        struct queue_entry *task_q = queue_new_node(task); // create queue entry
-        queue_insert_tail(&(t->squeue[j]), task_q); // insert queue entry to tail
-        pthread_cond_signal(&(t->scond[j])); // signal secondary condition variable as only
-                                             // one thread will ever wait for pcond
-        if (SIGNAL_PRIMARY_ON_NEW_SECONDARY_TASK == 1)
-            pthread_cond_signal(&(t->pcond)); // signal primary condition variable
-        pthread_mutex_unlock(&(t->smutex[j])); // unlock mutex
+        mpsc_push(&(t->pinbox), &(task->inject), task); // pExecutor moves it to primary ready queue
+        executor_wake_primary(t);
+    }
+}
+
+void task_place_batch(tboard_t *t, task_t **tasks, int n)
+{
+    exec_t *self = executor_current(t);
+    bool primary_self = (self != NULL && self->type == PRIMARY_EXEC);
+    struct mpsc_chain pchain, schain[MAX_SECONDARIES];
+    long pending[MAX_SECONDARIES] = {0};
+    bool secondary = false;
+    int sqs = t->sqs; // sExecutors may be added or retired meanwhile
+
+    mpsc_chain_init(&pchain);
+    for (int i=0; i<sqs; i++)
+        mpsc_chain_init(&(schain[i]));
+
+    // sort tasks into one chain per target queue
+    for (int k=0; k<n; k++) {
+        task_t *task = tasks[k];
+        if (task->type <= PRIMARY_EXEC || sqs == 0) {
+            if (primary_self) { // we are pExecutor, the only thread accessing the primary ready queue
+                struct queue_entry *task_q = queue_init_node(&(task->entry), task);
+                if (task->type == PRIORITY_EXEC)
+                    queue_insert_head(&(t->pqueue), task_q);
+                else
+                    queue_insert_tail(&(t->pqueue), task_q);
+            } else {
+                mpsc_chain_add(&pchain, &(task->inject), task);
+            }
+        } else {
+            int j = task_place_select(t, self, pending, sqs);
+            if (self != NULL && self->type == SECONDARY_EXEC && self->num == j)
+                deque_push(&(t->sdeque[j]), task); // our own deque, push without locking
+            else
+                mpsc_chain_add(&(schain[j]), &(task->inject), task);
+            pending[j]++;
+            secondary = true;
+        }
+    }
+
+    // one push and at most one wakeup per target queue
+    if (pchain.first != NULL) {
+        mpsc_push_chain(&(t->pinbox), &pchain);
+        executor_wake_primary(t);
+    }
+    for (int j=0; j<sqs; j++) {
+        if (pending[j] == 0)
+            continue;
+        if (schain[j].first == NULL) { // all went to our own deque
+            executor_wake_idle(t, j);
+            continue;
+        }
+        if (!executor_inbox_reserve(t, j, pending[j])) {
+            // sExecutor j is retiring, place its share one by one among the others. Read next
+            // link first, placing a task reuses its node
+            struct mpsc_node *node = schain[j].first, *next;
+            do {
+                next = atomic_load_explicit(&(node->next), memory_order_relaxed);
+                task_place(t, (task_t *)(node->data));
+            } while (node != schain[j].last && (node = next) != NULL);
+            continue;
+        }
+        mpsc_push_chain(&(t->sinbox[j]), &(schain[j]));
+        task_place_notify(t, j);
     }
+    if (secondary && SIGNAL_PRIMARY_ON_NEW_SECONDARY_TASK == 1)
+        executor_wake_primary(t); // pExecutor may steal it
 }
 
 bool task_add(tboard_t *t, task_t *task)
@@ -472,50 +843,240 @@ bool task_add(tboard_t *t, task_t *task)
     // initialize internal values
     task->cpu_time = 0;
     task->yields = 0;
+    task->level = 0;
+    task->level_time = 0;
     task->status = TASK_INITIALIZED;
-    task->hist = NULL;
-    // add task to history
-    history_record_exec(t, task, &(task->hist));
+    // add task to history, unless task_context_create() found its entry already
+    if (task->hist == NULL)
+        history_record_exec(t, task, &(task->hist));
     task->hist->executions += 1; // increase execution count
-    // add task to ready queue
+    // make task cancellable, then add it to ready queue
+    registry_add(t, task);
     task_place(t, task);
     return true;
 }
 
+int task_add_batch(tboard_t *t, task_t **tasks, int n)
+{
+    if (t == NULL || tasks == NULL || n <= 0)
+        return 0;
+
+    // reserve as many concurrent task slots as we can at once
+    int added = tboard_reserve_concurrent(t, n);
+    if (added == 0)
+        return 0;
+
+    // initialize internal values
+    for (int k=0; k<added; k++) {
+        tasks[k]->cpu_time = 0;
+        tasks[k]->yields = 0;
+        tasks[k]->level = 0;
+        tasks[k]->level_time = 0;
+        tasks[k]->status = TASK_INITIALIZED;
+        tasks[k]->hist = NULL;
+    }
+    // add tasks to history and registry, then to ready queues
+    history_record_batch(t, tasks, added);
+    for (int k=0; k<added; k++)
+        registry_add(t, tasks[k]);
+    task_place_batch(t, tasks, added);
+    return added;
+}
+
+int task_create_batch(tboard_t *t, function_t fn, int type, void **args, size_t sizeof_args, int n)
+{
+    if (t == NULL || n <= 0)
+        return 0;
+
+    mco_result res;
+    int created = 0;
+    task_t **tasks = calloc(n, sizeof(task_t *));
+    if (tasks == NULL)
+        return 0;
+
+    // reserve concurrent task slots up front so we do not build tasks we cannot add
+    int reserved = tboard_reserve_concurrent(t, n);
+    // whole batch shares a stack size class, picked once
+    task_t probe = {.fn = fn};
+    size_t stack_size = (reserved > 0) ? history_stack_size(t, &probe, reserved) : 0;
+    for (int k=0; k<reserved; k++) {
+        // create task_t object
+        task_t *task = task_alloc(t); // returned to pool on termination
+        if (task == NULL) {
+            tboard_err("task_create_batch: Failed to allocate task.\n");
+            break; // unused slots are given back below
+        }
+        task->status = TASK_INITIALIZED;
+        task->type = type;
+        task->id = 0; // assigned by registry_add()
+        task->fn = fn;
+        task->desc = task_desc_init(t, task->fn, (args != NULL) ? args[k] : NULL, stack_size);
+        task->data_size = sizeof_args;
+        task->parent = NULL;
+        task->stack_probe = probe.stack_probe;
+        task->stack_guard = probe.stack_guard;
+        if ( (res = mco_create(&(task->ctx), &(task->desc))) != MCO_SUCCESS ) {
+            tboard_err("task_create_batch: Failed to create coroutine: %s.\n",mco_result_description(res));
+            task_free(t, task);
+            break; // remaining arguments stay with the caller
+        }
+        if (task->stack_probe)
+            task_stack_paint(task->ctx); // covers guard too
+        else if (task->stack_guard)
+            task_stack_guard(task->ctx);
+        task->cpu_time = 0;
+        task->yields = 0;
+        task->hist = NULL;
+        tasks[created++] = task;
+    }
+    // give back slots we did not use
+    for (int k=created; k<reserved; k++)
+        tboard_deinc_concurrent(t);
+
+    if (created > 0) {
+        history_record_batch(t, tasks, created);
+        for (int k=0; k<created; k++)
+            registry_add(t, tasks[k]);
+        task_place_batch(t, tasks, created);
+    }
+    free(tasks);
+    return created;
+}
+
 bool task_create(tboard_t *t, function_t fn, int type, void *args, size_t sizeof_args)
+{
+    return task_create_id(t, fn, type, args, sizeof_args) != 0;
+}
+
+static uint64_t task_create_common(tboard_t *t, function_t fn, int type, const void *args, size_t sizeof_args, bool copy,
+                                   task_future_t *future)
 {
     if (t == NULL)
-        return false;
+        return 0;
 
     mco_result res;
 
     // create task_t object
-    task_t *task = calloc(1, sizeof(task_t));
+    task_t *task = task_alloc(t); // returned to pool on termination
+    if (task == NULL) { // no concurrent task slot is taken before task_add()
+        tboard_err("task_create: Failed to allocate task.\n");
+        return 0;
+    }
     task->status = TASK_INITIALIZED;
     task->type = type;
-    task->id = TASK_ID_NONBLOCKING;
+    // assign ID now, task may terminate before task_add() returns
+    uint64_t id = registry_next_id();
+    task->id = id;
     task->fn = fn;
-    // create description and populate it with argument
-    task->desc = mco_desc_init((task->fn.fn), 0);
-    task->desc.user_data = args;
-    task->data_size = sizeof_args;
     // non-blocking task so no parent
     task->parent = NULL;
-    // create coroutine
-    if ( (res = mco_create(&(task->ctx), &(task->desc))) != MCO_SUCCESS ) {
+    task->future = future;
+    if (future != NULL)
+        future->id = id;
+    void *user_data;
+    if (copy) { // small arguments are kept in task_t itself
+        user_data = task_copy_args(task, args, sizeof_args);
+        if (user_data == NULL && args != NULL && sizeof_args > 0) {
+            tboard_err("task_create_copy: Failed to copy %zu bytes of task arguments.\n", sizeof_args);
+            task_free(t, task);
+            return 0;
+        }
+    } else {
+        user_data = (void *)args;
+        task->data_size = sizeof_args;
+    }
+    // create coroutine with a stack sized for its function, and populate it with argument
+    if ( (res = task_context_create(t, task, user_data)) != MCO_SUCCESS ) {
         tboard_err("task_create: Failed to create coroutine: %s.\n",mco_result_description(res));
-        
-        free(task);
-        return false;
+        if (copy && task->data_size > 0)
+            free(user_data);
+        task_free(t, task);
+        return 0;
     } else {
         // attempt to add task to tboard
         bool added = task_add(t, task);
         if (!added){
             mco_destroy(task->ctx); // we must destroy stack allocated in mco_create() on failure
-            free(task); // free task, as it turns out we cannot use it
+            if (copy && task->data_size > 0)
+                free(user_data); // copy is ours, caller still owns @args
+            task_free(t, task); // return task to pool, as it turns out we cannot use it
         }
-        return added;
+        return added ? id : 0;
+    }
+}
+
+uint64_t task_create_id(tboard_t *t, function_t fn, int type, void *args, size_t sizeof_args)
+{
+    return task_create_common(t, fn, type, args, sizeof_args, false, NULL);
+}
+
+bool task_create_copy(tboard_t *t, function_t fn, int type, const void *args, size_t sizeof_args)
+{
+    return task_create_common(t, fn, type, args, sizeof_args, true, NULL) != 0;
+}
+
+task_future_t *task_spawn(tboard_t *t, function_t fn, int type, void *args, size_t sizeof_args)
+{
+    task_future_t *future = calloc(1, sizeof(task_future_t)); // free'd by task_join_all()
+    if (future == NULL)
+        return NULL;
+    future->tboard = t;
+    atomic_init(&(future->join), NULL);
+    // child may terminate before we return, completing future already
+    if (task_create_common(t, fn, type, args, sizeof_args, false, future) == 0) {
+        free(future);
+        return NULL;
     }
+    // future belongs to us if we are a task, released along with us should we never join it
+    exec_t *self = executor_current(t);
+    if (self != NULL && self->running != NULL) {
+        future->owner = self->running;
+        future->next = future->owner->futures;
+        if (future->next != NULL)
+            future->next->prev = future;
+        future->owner->futures = future;
+    }
+    return future;
+}
+
+void *task_copy_args(task_t *task, const void *args, size_t sizeof_args)
+{
+    task->data_size = 0;
+    if (args == NULL || sizeof_args == 0)
+        return NULL;
+    if (sizeof_args <= TASK_ARGS_INLINE) { // lives and dies with task_t, nothing to free
+        memcpy(task->args, args, sizeof_args);
+        return task->args;
+    }
+    void *copy = malloc(sizeof_args); // free'd when task terminates
+    if (copy == NULL)
+        return NULL;
+    memcpy(copy, args, sizeof_args);
+    task->data_size = sizeof_args;
+    return copy;
+}
+
+context_desc task_desc_init(tboard_t *t, function_t fn, void *args, size_t stack_size)
+{
+    context_desc desc = mco_desc_init((fn.fn), stack_size);
+    desc.user_data = args;
+    // coroutine context and stack are taken from and returned to task board's stack pool
+    desc.malloc_cb = task_stack_alloc;
+    desc.free_cb = task_stack_free;
+    desc.allocator_data = t;
+    return desc;
+}
+
+mco_result task_context_create(tboard_t *t, task_t *task, void *args)
+{
+    // stack size class comes from history of task function, which may want it probed
+    task->desc = task_desc_init(t, task->fn, args, history_stack_size(t, task, 1));
+    mco_result res = mco_create(&(task->ctx), &(task->desc));
+    if (res == MCO_SUCCESS && task->stack_probe)
+        task_stack_paint(task->ctx); // covers guard too
+    else if (res == MCO_SUCCESS && task->stack_guard)
+        task_stack_guard(task->ctx);
+    return res;
 }
 
 void task_destroy(task_t *task)
@@ -526,12 +1087,14 @@ void task_destroy(task_t *task)
     // queue so we must destroy it (does it recursively)
     if (task->parent != NULL)
         task_destroy(task->parent);
+    // release futures, and parent parked in task_join_all() if we were last it waited for
+    future_destroy(task);
     // destroy user data if applicable
     if (task->data_size > 0 && task->desc.user_data != NULL)
         free(task->desc.user_data);
     // destroy coroutine
     mco_destroy(task->ctx);
-    // free task_t
+    // free task_t. Only called on task board destruction, so task is not returned to pool
     free(task);
 }
 
@@ -541,6 +1104,17 @@ void task_yield()
     mco_yield(mco_running());
 }
 
+void task_sleep(uint64_t ns)
+{
+    task_yield_until(timer_now() + ns);
+}
+
+void task_yield_until(uint64_t deadline)
+{
+    // executor puts us in the timer wheel instead of a ready queue
+    executor_yield(YIELD_SLEEP, NULL, deadline);
+}
+
 void *task_get_args()
 {
     // get arguments of currently running task
@@ -6,12 +6,19 @@
 
 #include <sys/queue.h>
 #include "queue/queue.h"
+#include "queue/deque.h"
+#include "queue/mpsc.h"
+#include "parker.h"
 
 
 #include <minicoro.h>
 #include <uthash.h>
+#include <uuid4.h>
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <pthread.h>
 
 ///////////////////////////////
@@ -19,13 +26,56 @@
 ///////////////////////////////
 
 #define MAX_TASKS 65536 // 8196
-#define MAX_SECONDARIES 10
-#define STACK_SIZE 57344 // in bytes
+#define MAX_SECONDARIES 64 // sExecutors a task board can grow to (see tboard_add_secondary())
+#define STACK_SIZE 57344 // in bytes, largest coroutine stack size class
+#define STACK_CLASSES 4 // coroutine stack size classes, each half the size of the next (see task_context_create())
+#define STACK_MIN_SIZE (STACK_SIZE >> (STACK_CLASSES - 1)) // smallest stack size class
+#define STACK_MARGIN 2 // stack size class of a task function holds at least this many times its peak usage
+#define STACK_PROBE_RUNS 8 // executions of each task function probed for stack usage before picking its class
+#define STACK_PROBE_INTERVAL 64 // afterwards, one in this many executions is probed again
+#define STACK_PROFILE_BUCKET 256 // bytes per stack usage histogram bucket (see tboard_set_stack_profile())
+#define DEFAULT_STACK_PROFILE false
+#define DEFAULT_STACK_SIZING false // tasks run on STACK_SIZE stacks unless tboard_set_stack_sizing() is enabled
+#define STACK_GUARD 512 // bytes at far end of a downsized stack checked for overflow after every slice
 #define REINSERT_PRIORITY_AT_HEAD 1 
+#define POOL_CACHE_SIZE (MAX_TASKS / 256) // task objects each executor caches per pool
+#define STACK_POOL_SIZE 1024 // free coroutine stacks of each size class retained by task board
+#define STACK_CACHE_SIZE 32 // free coroutine stacks of each size class each executor caches
+#define INBOX_BATCH 256 // tasks an executor moves from its injection queue per iteration
+#define STEAL_BATCH 128 // most tasks an sExecutor steals from a sibling at once, up to half of what it has
+#define TASK_ARGS_INLINE 64 // bytes of task arguments task_create_copy() keeps in task_t instead of allocating
+#define PARALLEL_SLICE 200000 // ns of work tboard_parallel_for() aims for between yields, when sizing grain
+#define PARALLEL_WAIT 10000000 // ns a thread waiting in tboard_parallel_for() sleeps between checks for shutdown
+#define SPIN_BLOCK_ITERATIONS 128 // idle iterations an executor polls with a pause before yielding
+#define YIELD_BLOCK_ITERATIONS 8 // idle iterations an executor yields its CPU before parking
+#define MAX_CPUS 1024 // highest CPU number + 1 executors can be pinned to
+#define AFFINITY_WORDS ((MAX_CPUS + 63) / 64)
+#define MLFQ_LEVELS 4 // secondary feedback queue levels, including work-stealing deque at level 0
+#define MLFQ_QUANTUM 1000 // CPU time (clock() units) a task may use at level 0, doubling per level
+#define MLFQ_BOOST_INTERVAL 100 // ms between moving all secondary tasks back to level 0
+#define DEFAULT_MLFQ false
+#define TIMER_RESOLUTION 1000000 // timer wheel tick in ns
+#define TIMER_LEVELS 4 // timer wheel levels, each spanning TIMER_SLOTS slots of the level below
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS) // slots per timer wheel level
+#define AUTOSCALE_INTERVAL 100 // ms between autoscaler decisions
+#define AUTOSCALE_QUEUE_DEPTH 4 // queued secondary tasks per sExecutor, with none idle, before adding one
+#define AUTOSCALE_QUIET_PERIODS 10 // intervals with an idle sExecutor and nothing queued before retiring one
+#define REGISTRY_SHARDS 64 // task registry shards, each with its own lock (see task_cancel())
+#define ID_BLOCK_SIZE 4096 // task IDs each thread claims at once (see registry_next_id())
 
 #define DEBUG 0
 
 #define SIGNAL_PRIMARY_ON_NEW_SECONDARY_TASK 1
+
+#define PLACEMENT_POWER_OF_TWO 0 // shorter of two randomly chosen secondary queues
+#define PLACEMENT_ROUND_ROBIN 1 // secondary queues in turn
+#define PLACEMENT_LOCAL 2 // caller's own secondary queue if caller is an sExecutor
+#define DEFAULT_PLACEMENT PLACEMENT_POWER_OF_TWO
+
+#define SECONDARY_STOPPED 0 // sExecutor thread was not started, or has been joined
+#define SECONDARY_RUNNING 1
+#define SECONDARY_RETIRED 2 // told to retire by tboard_remove_secondary(), not joined yet
 /**
  *  This will wake up primary executor when a
  *  secondary task is inserted into the task queue
@@ -47,8 +97,7 @@
 #define TASK_EXEC 0 // for msg_processor
 #define TASK_SCHEDULE 1 // for msg_processor
 
-#define TASK_ID_REMOTE_ISSUED -1
-#define TASK_ID_NONBLOCKING 0
+#define TASK_ID_NONBLOCKING 0 // @blocking argument of remote_task_create(), tasks get unique IDs
 #define TASK_ID_BLOCKING 1
 
 #define TASK_INITIALIZED 1
@@ -62,6 +111,7 @@
 
 // Set MCO values
 #define MCO_DEFAULT_STACK_SIZE STACK_SIZE
+#define MCO_MIN_STACK_SIZE STACK_MIN_SIZE
 
 
 ///////////////////////////////////////////////////////////////////
@@ -113,12 +163,43 @@ typedef struct {
 
 #define TBOARD_FUNC(func) (function_t){.fn = func, .fn_name = #func}
 
+/**
+ * tb_range_f - Range function prototype of tboard_parallel_for().
+ * tb_reduce_f - Range function prototype of tboard_parallel_reduce(), accumulating into @acc.
+ * tb_combine_f - Combines accumulator @other into @acc, for tboard_parallel_reduce().
+ * 
+ * Range functions must have signature `void fn(int64_t begin, int64_t end, void *ctx)`, or
+ * `void fn(int64_t begin, int64_t end, void *ctx, void *acc)` when reducing, and handle
+ * elements @begin up to but not including @end.
+ */
+typedef void (*tb_range_f)(int64_t, int64_t, void *);
+typedef void (*tb_reduce_f)(int64_t, int64_t, void *, void *);
+typedef void (*tb_combine_f)(void *, const void *, void *);
+
+/**
+ * range_function_t - Range function and its name, like function_t
+ * @range:   function pointer, for tboard_parallel_for()
+ * @reduce:  function pointer, for tboard_parallel_reduce()
+ * @fn_name: common function name, keys history of its grain size
+ * 
+ * Generated by macros TBOARD_RANGE(fn) and TBOARD_REDUCE(fn).
+ */
+typedef struct {
+    tb_range_f range;
+    tb_reduce_f reduce;
+    const char *fn_name;
+} range_function_t;
+
+#define TBOARD_RANGE(func) (range_function_t){.range = func, .reduce = NULL, .fn_name = #func}
+#define TBOARD_REDUCE(func) (range_function_t){.range = NULL, .reduce = func, .fn_name = #func}
+
 struct history_t;
 struct exec_t;
 
 /**
  * task_t - Data type containing task information
- * @id:         Task ID representing source of task
+ * @id:         Unique task ID, assigned when task is added to task board (see task_cancel()).
+ *              0 if task is not registered, as for blocking child tasks
  * @status:     Status of current task
  *              @status == 0: task was issued
  *              @status == 1: task is running
@@ -137,13 +218,40 @@ struct exec_t;
  *              this should be 0, meaning non-zero values are indictive of allocated user data
  * @hist:       Pointer to history_t object in hash table
  * @parent:     Link to parent task if task type is blocking (NULL value indicates non-blocking)
+ * @entry:      Intrusive ready queue link. A task is in at most one ready queue at a time, so
+ *              it carries its own queue entry and queueing it never allocates
+ * @inject:     Intrusive link for the lock-free injection queues (tboard_t @pinbox, @sinbox and
+ *              @sched_inbox)
+ * @est:        Earliest start time of a scheduled task, in ms since task board creation
+ * @lst:        Latest start time of a scheduled task. Deadline is met if task starts by then
+ * @scheduled:  Task was admitted by bid_processing() and is ordered by deadline on pExecutor
+ * @wake_at:    Time task sleeps until in timer wheel, as returned by timer_now()
+ * @timer_link: Timer wheel link. Doubly linked, so task_cancel() can unlink a sleeping task
+ * @timer_slot: Timer wheel slot task sleeps in, NULL if it is not asleep. Protected by
+ *              tboard_t @timer_mutex
+ * @remote:     Blocking remote task this task waits on, NULL if none. Protected by tboard_t
+ *              @msg_mutex
+ * @level:      Feedback queue level of secondary task, 0 being the highest (see tboard_set_mlfq())
+ * @level_time: CPU time task used at its current @level
+ * @cancelled:  Set by task_cancel(). Task is discarded by whichever executor takes it next
+ * @rh:         Hash handle of task registry, see registry_add()
+ * @stack_probe: Coroutine stack was painted by task_stack_paint() and is scanned for its peak
+ *              usage once task terminates (see task_context_create())
+ * @stack_used: Peak stack usage in bytes found by task_stack_scan(), set before history is recorded
+ * @stack_guard: Coroutine stack is smaller than STACK_SIZE, and its last STACK_GUARD bytes were
+ *              painted by task_stack_guard() to be checked after every slice
+ * @args:       Inline argument storage. Arguments of up to TASK_ARGS_INLINE bytes copied by
+ *              task_create_copy() live here, and @desc.user_data points at it
+ * @future:     Handle of task created by task_spawn(), completed once task terminates
+ * @futures:    Futures of children this task spawned and has not joined yet, linked through
+ *              their @next. Only touched by the task itself, or by whoever releases it
  * 
  * Structure contains all necessary information relating to a task.
  * 
  * Generation of this structure is done internally by task_create() functions and MQTT adapter
  */
 typedef struct task_t {
-    int id;
+    uint64_t id;
     int status;
     int type;
     int cpu_time;
@@ -154,8 +262,29 @@ typedef struct task_t {
     size_t data_size;
     struct history_t *hist;
     struct task_t *parent;
+    struct queue_entry entry;
+    struct mpsc_node inject;
+    int est;
+    int lst;
+    bool scheduled;
+    uint64_t wake_at;
+    TAILQ_ENTRY(task_t) timer_link;
+    struct timer_slot *timer_slot;
+    struct remote_task_t *remote;
+    int level;
+    int level_time;
+    atomic_bool cancelled;
+    UT_hash_handle rh;
+    bool stack_probe;
+    size_t stack_used;
+    bool stack_guard;
+    struct task_future_t *future;
+    struct task_future_t *futures;
+    _Alignas(max_align_t) unsigned char args[TASK_ARGS_INLINE];
 } task_t;
 
+TAILQ_HEAD(timer_slot, task_t); // slot of timer wheel, see tboard_t @timer_wheel
+
 /**
  * remote_task_t - Remote task type
  * @status:       status of remote task
@@ -164,6 +293,13 @@ typedef struct task_t {
  * @data_size:    size of data/response. non-zero value indicative of alloc'd data 
  * @calling_task: task_t pointer to task that issued remote task
  * @blocking:     indicate whether or not remote task is blocking
+ * @issuer:       executor that issued remote task. Its doorbell is rung once response is placed
+ *                in incoming task queue, so it runs TSeq to handle the response
+ * @task_id:      ID of @calling_task, or of its closest ancestor if it is a blocking child task.
+ *                Adapters send it as a string from task_id_to_uuid() to correlate responses
+ * @abandoned:    @calling_task was cancelled while it waited on blocking remote task, so it is
+ *                released once the response arrives instead of being resumed. Protected by
+ *                tboard_t @msg_mutex
  * 
  * Any remote interface must be able to pull this from outgoing task queue and interpret it.
  * Once request has been fulfilled, it must be placed back into the incoming task queue
@@ -176,41 +312,168 @@ typedef struct task_t {
  * is recieved. Otherwise, it will be placed back into the appropriate ready queue after task is
  * issued by MQTT adapter.
  */
-typedef struct {
+typedef struct remote_task_t {
     int status;
     char message[MAX_MSG_LENGTH+1]; // +1 for '\0'
     void *data;
     size_t data_size;
     task_t *calling_task;
     bool blocking;
+    struct exec_t *issuer;
+    uint64_t task_id;
+    bool abandoned;
 } remote_task_t;
 
 
 
+/**
+ * pool_t - Object pool shared by all threads of a task board
+ * @size:       size of pooled objects
+ * @capacity:   maximum number of free objects retained in @free, extra objects are released
+ * @cache_size: maximum number of free objects each executor's pool_cache_t retains
+ * @batch:      number of objects moved between an executor's cache and @free at once
+ * @zero:       whether objects are zeroed on allocation
+ * @count:      number of free objects currently in @free
+ * @free:       shared free list of objects
+ * @mutex:      locked when accessing @free
+ * @hits:       allocations served from @free by threads without a cache
+ * @misses:     allocations by threads without a cache that fell back on malloc()
+ * 
+ * Executors do not touch @free on every allocation, they allocate from their own pool_cache_t
+ * which is refilled from and spilled to @free @batch objects at a time.
+ */
+typedef struct {
+    size_t size;
+    int capacity;
+    int cache_size;
+    int batch;
+    bool zero;
+    int count;
+    void *free;
+    pthread_mutex_t mutex;
+    atomic_long hits;
+    atomic_long misses;
+} pool_t;
+
+/**
+ * pool_cache_t - Per-executor cache of a pool_t
+ * @free:   free list of objects owned by executor
+ * @count:  number of objects in @free, kept at or below pool's @cache_size
+ * @hits:   allocations served from cache (after refilling from pool if needed)
+ * @misses: allocations that fell back on malloc()
+ * 
+ * Only accessed by the executor thread that owns it, so no locking is required.
+ */
+typedef struct {
+    void *free;
+    int count;
+    long hits;
+    long misses;
+} pool_cache_t;
+
 /**
  * tboard_t - Task Board object.
  * @primary:    Thread of primary task executor (pExecutor)
  * @secondary:  Threads of secondary task executors (sExecutor)
- * @pcond:      Condition variable of pExecutor
- * @scond:      Condition variables of sExecutor
- * @pmutex:     Mutex of pExecutor
- * @smutex:     Mutexs of sExecutor
- * @cmutex:     Task count mutex, locked when changing concurrent task count
+ * @pparker:    Parker pExecutor sleeps on when idle
+ * @sparker:    Parkers sExecutors sleep on when idle
  * @tmutex:     Task board mutex, locking only when significantly modifying tboard 
  * @tcond:      Task board condition variable. This signals once all task executor threads
  *              have been joined in tboard_destroy()
  * @emutex:     Task board exit mutex, locking only when shutdown initializes. 
- * @pqueue:     Primary task ready queue
- * @squeue:     Secondary task ready queues
+ * @pqueue:     Primary task ready queue, only accessed by pExecutor
+ * @pinbox:     Primary task injection queue. Primary tasks placed by any thread other than
+ *              pExecutor land here without locking, and are moved into @pqueue by pExecutor
+ * @sdeque:     Secondary task ready queues. Work-stealing deques owned by respective sExecutor.
+ *              Only the owning sExecutor pushes to its deque, any executor may steal from it
+ * @sinbox:     Secondary task injection queues. Tasks placed into a secondary by any thread other
+ *              than its sExecutor land here without locking, and are moved into @sdeque by the
+ *              owner in batches of up to INBOX_BATCH. Idle siblings may take tasks from the inbox
+ *              of a busy sExecutor while it does not hold the consumer role
+ * @pidle:      Non-zero while pExecutor is parked or about to park
+ * @sidle:      Non-zero while respective sExecutor is parked or about to park
+ * @idle_count: Number of sExecutors currently asleep, read to skip waking when none are idle
+ * @sinbox_len: Number of tasks in respective @sinbox, incremented before a task is pushed, so
+ *              it is non-zero while a push is in progress. Read by task placement and sleepers
+ * @placement:  Secondary task placement policy, one of PLACEMENT_* (see tboard_set_placement())
+ * @place_next: Next secondary queue under PLACEMENT_ROUND_ROBIN
+ * @idle_spin:  Idle iterations executors spin before yielding (see tboard_set_idle_policy())
+ * @idle_yield: Idle iterations executors yield before parking
+ * @paffinity:  Bit mask of CPUs pExecutor is pinned to, no pinning if empty (see tboard_set_affinity())
+ * @saffinity:  Bit masks of CPUs respective sExecutor is pinned to
+ * @mlfq:       Non-zero if secondary tasks are scheduled by feedback queues (see tboard_set_mlfq())
+ * @smlfq:      Lower feedback queue levels (1 to MLFQ_LEVELS-1) of each sExecutor, only accessed by
+ *              the owning sExecutor. Level 0 is @sdeque
+ * @mlfq_boost: Time (timer_now()) respective sExecutor next moves its tasks back to level 0
+ * @sched_epoch: Creation time of task board, bid EST and LST are relative to it
+ * @sched_inbox: Scheduled task injection queue. Tasks admitted by bid_processing() land here and
+ *              are moved into @sched_heap by pExecutor
+ * @sched_heap: Scheduled tasks ordered by earliest LST (binary min-heap), only accessed by pExecutor
+ * @sched_len:  Number of tasks in @sched_heap
+ * @sched_cap:  Allocated size of @sched_heap
+ * @sched_admitted: Number of bids admitted by bid_processing()
+ * @sched_rejected: Number of bids rejected because their LST had passed or EST was after LST
+ * @sched_hits: Number of scheduled tasks started no later than their LST
+ * @sched_misses: Number of scheduled tasks dropped because their LST passed before they could start
+ * @timer_mutex: Timer wheel mutex, locked when inserting into or advancing @timer_wheel
+ * @timer_wheel: Hierarchical timer wheel of sleeping tasks, TIMER_LEVELS levels of TIMER_SLOTS
+ *              slots. Tasks are linked through their @timer_link
+ * @timer_tick: Last tick (TIMER_RESOLUTION ns) processed by timer wheel
+ * @timer_count: Number of sleeping tasks in @timer_wheel
+ * @timer_next: Earliest tick pExecutor waits for when parked, adding an earlier timer wakes it
  * @msg_sent:   Message queue storing outgoing remote tasks
  * @msg_recv:   Message queue storing outgoing remote task responses
+ * @msg_pending: Number of responses in @msg_recv. Incremented when a response is queued, which rings
+ *              the doorbell of the issuing executor, read by TSeq without locking @msg_mutex
  * @msg_mutex:  Message queue mutex, locking only when modifying message queues or using @msg_cond
  * @msg_cond:   Message queue condition variable, used for external MQTT adapter to sleep on
- * @sqs:        Number of secondary ready queues and executors
- * @task_count: Tracks the number of concurrent tasks running in task board
+ * @sqs:        Number of secondary ready queues and executors. Changes while task board runs (see
+ *              tboard_add_secondary()), so readers placing tasks load it once
+ * @smax:       Number of sExecutor slots initialized so far. Slots of retired sExecutors stay
+ *              initialized, so queues and executor arguments below @smax are always valid
+ * @sstate:     State of respective sExecutor thread, one of SECONDARY_*. Protected by @smutex
+ * @sretire:    Set by tboard_remove_secondary() to tell respective sExecutor to hand its tasks
+ *              to the others and exit
+ * @smutex:     Serializes adding and retiring sExecutors, and tboard_kill() against both
+ * @autoscale:  Non-zero if autoscaler thread adjusts @sqs (see tboard_set_autoscale())
+ * @autoscaler: Autoscaler thread, see executor_autoscale()
+ * @scale_min:  Fewest sExecutors autoscaler retires down to
+ * @scale_max:  Most sExecutors autoscaler adds up to
+ * @scale_ups:  Number of sExecutors added by autoscaler
+ * @scale_downs: Number of sExecutors retired by autoscaler
+ * @slice_budget: Time (ns) a task may run without yielding before watchdog flags it, 0 if there is
+ *              no watchdog (see tboard_set_watchdog())
+ * @slice_quarantine: Non-zero if watchdog quarantines sExecutors running a flagged task
+ * @watchdog:   Watchdog thread, see executor_watchdog()
+ * @slice_overruns: Number of slices flagged by watchdog
+ * @squarantine: Set while respective sExecutor runs a task flagged by watchdog. Task placement
+ *              selects other queues meanwhile, cleared once the task yields or terminates
+ * @sstolen:    Number of tasks stolen from respective sExecutor's deque or inbox, by any thief
+ * @reg_mutex:  Locks of task registry shards
+ * @registry:   Task registry shards, hash tables of tasks keyed by @id. A task is in shard
+ *              @id % REGISTRY_SHARDS from task_add() until it terminates or is discarded
+ * @uuid_node:  Random first half of uuid4 strings task IDs are mapped to, see task_id_to_uuid()
+ * @reg_cancelled: Number of tasks discarded after task_cancel()
+ * @task_count: Tracks the number of concurrent tasks running in task board. Updated atomically,
+ *              admission against MAX_TASKS uses compare-exchange
+ * @ext_adds:   Tasks added by threads that are not executors, see tboard_get_concurrent_approx()
+ * @ext_ends:   Tasks released by threads that are not executors
  * @exec_hist:  Task execution history hash table
+ * @stack_profile: Stack of every task is probed and its usage aggregated in history, instead of
+ *              only those picked by history_stack_size() (see tboard_set_stack_profile())
+ * @stack_sizing: Stack size class of tasks is picked from history, instead of always being
+ *              STACK_SIZE (see tboard_set_stack_sizing())
+ * @parallel_mutex: Locks @parallel_jobs
+ * @parallel_jobs: Parallel loops started by threads that are not tasks, whose root task has not
+ *              terminated yet. Released by parallel_destroy() if task board is destroyed first
+ * @task_pool:  Pool of task_t objects, retaining up to MAX_TASKS free objects
+ * @rtask_pool: Pool of remote_task_t objects, retaining up to MAX_TASKS free objects
+ * @stack_pool: Pools of coroutine contexts including their stacks, one per stack size class from
+ *              STACK_MIN_SIZE up to STACK_SIZE, each retaining up to STACK_POOL_SIZE free contexts.
+ *              Finished contexts are reinitialized by mco_create() instead of being allocated again
  * @pexect:     pointer to pExecutor argument
- * @sexect:     pointer to sExecutor arguments
+ * @sexect:     pointer to sExecutor arguments. Stored before @smax covers the slot, so a reader that
+ *              loaded @smax with acquire semantics finds it filled in (or NULL until task board starts)
  * @status:     Task board status.
  *              @status == 0: Task Board has been created
  *              @status == 1: Task Board has started
@@ -230,13 +493,8 @@ typedef struct {
     pthread_t primary;
     pthread_t secondary[MAX_SECONDARIES];
 
-    pthread_cond_t pcond;
-    pthread_cond_t scond[MAX_SECONDARIES];
-
-    pthread_mutex_t pmutex;
-    pthread_mutex_t smutex[MAX_SECONDARIES];
-
-    pthread_mutex_t cmutex;
+    parker_t pparker;
+    parker_t sparker[MAX_SECONDARIES];
 
     pthread_mutex_t tmutex;
     pthread_cond_t tcond;
@@ -245,35 +503,155 @@ typedef struct {
     pthread_mutex_t hmutex;
 
     struct queue pqueue;
-    struct queue squeue[MAX_SECONDARIES];
+    struct mpsc_queue pinbox;
+    struct deque sdeque[MAX_SECONDARIES];
+    struct mpsc_queue sinbox[MAX_SECONDARIES];
+
+    atomic_int pidle;
+    atomic_int sidle[MAX_SECONDARIES];
+    atomic_int idle_count;
+    atomic_int sinbox_len[MAX_SECONDARIES];
+
+    int placement;
+    atomic_uint place_next;
+
+    int idle_spin;
+    int idle_yield;
+
+    uint64_t paffinity[AFFINITY_WORDS];
+    uint64_t saffinity[MAX_SECONDARIES][AFFINITY_WORDS];
+
+    bool mlfq;
+    struct queue smlfq[MAX_SECONDARIES][MLFQ_LEVELS - 1];
+    uint64_t mlfq_boost[MAX_SECONDARIES];
+
+    struct timespec sched_epoch;
+    struct mpsc_queue sched_inbox;
+    task_t **sched_heap;
+    int sched_len;
+    int sched_cap;
+    atomic_long sched_admitted;
+    atomic_long sched_rejected;
+    atomic_long sched_hits;
+    atomic_long sched_misses;
+
+    pthread_mutex_t timer_mutex;
+    struct timer_slot timer_wheel[TIMER_LEVELS][TIMER_SLOTS];
+    _Atomic uint64_t timer_tick;
+    atomic_int timer_count;
+    uint64_t timer_next;
 
     struct queue msg_sent;
     struct queue msg_recv;
+    atomic_int msg_pending;
 
     pthread_mutex_t msg_mutex;
     pthread_cond_t msg_cond;
 
-    int sqs;
-
-    int task_count;
+    atomic_int sqs;
+    atomic_int smax;
+    int sstate[MAX_SECONDARIES];
+    atomic_bool sretire[MAX_SECONDARIES];
+    pthread_mutex_t smutex;
+
+    bool autoscale;
+    pthread_t autoscaler;
+    int scale_min;
+    int scale_max;
+    long scale_ups;
+    long scale_downs;
+
+    uint64_t slice_budget;
+    bool slice_quarantine;
+    pthread_t watchdog;
+    atomic_long slice_overruns;
+    atomic_bool squarantine[MAX_SECONDARIES];
+    atomic_long sstolen[MAX_SECONDARIES];
+
+    pthread_mutex_t reg_mutex[REGISTRY_SHARDS];
+    task_t *registry[REGISTRY_SHARDS];
+    uint64_t uuid_node;
+    atomic_long reg_cancelled;
+
+    atomic_int task_count;
+    atomic_long ext_adds;
+    atomic_long ext_ends;
 
     struct history_t *exec_hist;
+    bool stack_profile;
+    bool stack_sizing;
+
+    pthread_mutex_t parallel_mutex;
+    struct parallel_job *parallel_jobs;
+
+    pool_t task_pool;
+    pool_t rtask_pool;
+    pool_t stack_pool[STACK_CLASSES];
 
     struct exec_t *pexect;
-    struct exec_t *sexect[MAX_SECONDARIES];
+    struct exec_t *_Atomic sexect[MAX_SECONDARIES];
 
     int shutdown; // should be set to 0 unless told to end after all tasks are completed
     int status;
 } tboard_t;
 
+#define YIELD_NONE 0 // plain task_yield(), task goes back to its ready queue
+#define YIELD_CHILD 1 // blocking_task_create(), @target is child task_t to run in task's place
+#define YIELD_REMOTE 2 // remote_task_create(), @target is remote_task_t to send
+#define YIELD_SLEEP 3 // task_yield_until(), task waits in timer wheel until @wake_at
+#define YIELD_JOIN 4 // task_join_all(), @target is task_join_t task waits on
+
+/**
+ * yield_request_t - What a task asks of its executor when it yields
+ * @kind:    one of the YIELD_* values above
+ * @target:  object handed to executor, its type depends on @kind
+ * @wake_at: wake up time of YIELD_SLEEP, as returned by timer_now()
+ * 
+ * Set through executor_yield() right before task yields, and read and reset by the executor
+ * that resumed it as soon as it gets control back. Objects are handed over by pointer, so
+ * no request copies a task_t or remote_task_t.
+ */
+typedef struct {
+    int kind;
+    void *target;
+    uint64_t wake_at;
+} yield_request_t;
+
 /**
  * exec_t - Argument passed to task executor.
  * @type:   indicates whether task executor is primary or secondary.
  * @num:    If TExec is sExecutor, then @num identifies sExecutor.
  * @tboard: Reference to task board.
- * 
- * This type is exclusively used by tboard_start(), where it is created, and by tboard_destroy() where
- * it is freed.
+ * @task_cache:  Executor's cache of @tboard->task_pool
+ * @rtask_cache: Executor's cache of @tboard->rtask_pool
+ * @stack_cache: Executor's caches of @tboard->stack_pool, one per stack size class
+ * @idle_spins:  Number of times executor entered spin phase of its idle policy
+ * @idle_yields: Number of times executor entered yield phase of its idle policy
+ * @idle_parks:  Number of times executor parked
+ * @task_adds:   Shard of concurrent task count: tasks added by this executor. Only written by
+ *               the executor itself, so updating it never contends with other threads
+ * @task_ends:   Shard of concurrent task count: tasks released by this executor
+ * @mlfq_demotions:  Number of secondary tasks demoted to a lower feedback queue level after running here
+ * @mlfq_promotions: Number of secondary tasks promoted to a higher feedback queue level
+ * @mlfq_boosts:     Number of times sExecutor moved all its tasks back to level 0
+ * @slice_start:  Time (timer_now()) executor resumed the task it is running, 0 between tasks.
+ *                Only maintained if task board has a watchdog
+ * @slice_hist:   History entry of the task executor is running, for watchdog attribution
+ * @slice_flagged: @slice_start of the last slice flagged by watchdog, only accessed by watchdog
+ * @slice_overruns: Number of slices of this executor flagged by watchdog
+ * @steal_next:  sExecutor this executor tries to steal from first next time. Advances after every
+ *               scan, so no victim is always robbed first
+ * @steals:      Number of successful steals (batches) by this executor
+ * @steal_tasks: Number of tasks stolen by this executor
+ * @running:     Task executor is running, NULL between tasks. Only accessed by the executor
+ *               itself and the task it runs, see task_join_all()
+ * @request:     Request of the task executor is running, set by executor_yield() when it yields
+ * @localized:   Set once a pinned sExecutor moved its deque to its own NUMA node. Later arrays are
+ *               allocated by the owner, so an sExecutor restarted in this slot keeps the deque as is
+ * 
+ * This type is exclusively used by tboard_start() and tboard_add_secondary(), where it is created,
+ * and by tboard_destroy() where it is freed. Argument of a retired sExecutor is kept, and reused
+ * should its slot be added again.
  * 
  * Objects of this type are passed to executor() by tboard_start(), dictating executor() functionality.
  */
@@ -281,6 +659,27 @@ typedef struct exec_t { // passed to executor thread so it knows what to do
     int type;
     int num;
     tboard_t *tboard;
+    pool_cache_t task_cache;
+    pool_cache_t rtask_cache;
+    pool_cache_t stack_cache[STACK_CLASSES];
+    long idle_spins;
+    long idle_yields;
+    long idle_parks;
+    atomic_long task_adds;
+    atomic_long task_ends;
+    long mlfq_demotions;
+    long mlfq_promotions;
+    long mlfq_boosts;
+    _Atomic uint64_t slice_start;
+    struct history_t *_Atomic slice_hist;
+    uint64_t slice_flagged;
+    long slice_overruns;
+    int steal_next;
+    long steals;
+    long steal_tasks;
+    task_t *running;
+    yield_request_t request;
+    bool localized;
 } exec_t;
 
 
@@ -300,7 +699,250 @@ typedef struct schedule_t{
 } schedule_t;
 
 ///////////////////////////////////////////////
-/////////// Sequencer Definitions /////////////
+///////////// Timer Definitions ///////////////
+///////////////////////////////////////////////
+
+uint64_t timer_now();
+/**
+ * timer_now() - Current time of task board timers.
+ * 
+ * Return: CLOCK_MONOTONIC time in nanoseconds. Deadlines of task_yield_until() use this time base.
+ */
+
+void timer_init(tboard_t *t);
+/**
+ * timer_init() - Initializes timer wheel of task board. Called by tboard_create().
+ * @t: tboard_t pointer to task board.
+ */
+
+void timer_destroy(tboard_t *t);
+/**
+ * timer_destroy() - Destroys tasks still asleep in timer wheel. Called by tboard_destroy().
+ * @t: tboard_t pointer to task board.
+ */
+
+bool timer_add(tboard_t *t, task_t *task, uint64_t wake_at);
+/**
+ * timer_add() - Puts task to sleep in timer wheel.
+ * @t:       tboard_t pointer to task board.
+ * @task:    task that yielded via task_sleep() or task_yield_until(), in no ready queue.
+ * @wake_at: time to return @task to a ready queue at, as returned by timer_now().
+ * 
+ * Called by task executor. Wakes pExecutor if it is parked until a later expiry.
+ * 
+ * Context: locks @t->timer_mutex.
+ * 
+ * Return: true if @task is asleep, false if @wake_at has already passed or @task was cancelled,
+ *         in which case caller must place @task itself.
+ */
+
+bool timer_remove(tboard_t *t, task_t *task);
+/**
+ * timer_remove() - Takes task out of timer wheel before it wakes.
+ * @t:    tboard_t pointer to task board.
+ * @task: task that may be asleep in timer wheel.
+ * 
+ * Called by task_cancel(). Unlinks @task from its slot in constant time if it is asleep.
+ * 
+ * Context: locks @t->timer_mutex.
+ * 
+ * Return: true if @task was asleep, so caller now holds the only reference to it.
+ */
+
+void timer_advance(tboard_t *t);
+/**
+ * timer_advance() - Advances timer wheel to current time.
+ * @t: tboard_t pointer to task board.
+ * 
+ * Called by every task executor at each iteration. Tasks whose time has come are returned to
+ * ready queues via task_place(). Returns right away if no task is asleep, no tick has passed,
+ * or another executor is advancing the wheel.
+ * 
+ * Context: tries to lock @t->timer_mutex, never blocks.
+ */
+
+long timer_wait(tboard_t *t);
+/**
+ * timer_wait() - Time until timer wheel needs to be advanced next.
+ * @t: tboard_t pointer to task board.
+ * 
+ * Used by pExecutor to bound how long it parks, and records the tick it waits for in
+ * @t->timer_next. May be earlier than the next expiry if tasks need to cascade down the wheel.
+ * 
+ * Context: Only called by pExecutor, locks @t->timer_mutex.
+ * 
+ * Return: nanoseconds to wait, 0 if timers are due, -1 if no task is asleep.
+ */
+
+///////////////////////////////////////////////
+///////////// Registry Definitions ////////////
+///////////////////////////////////////////////
+
+void registry_init(tboard_t *t);
+/**
+ * registry_init() - Initializes task registry of task board. Called by tboard_create().
+ * @t: tboard_t pointer to task board.
+ */
+
+void registry_destroy(tboard_t *t);
+/**
+ * registry_destroy() - Empties task registry. Called by tboard_destroy() before it destroys
+ *                      remaining tasks, as registry hash tables are kept in them.
+ * @t: tboard_t pointer to task board.
+ */
+
+uint64_t registry_next_id();
+/**
+ * registry_next_id() - Returns a task ID that was never assigned before in this process, never 0.
+ * 
+ * Each thread (executors included) claims blocks of ID_BLOCK_SIZE consecutive IDs from a
+ * process-wide counter and hands them out without synchronization, so the shared counter is
+ * touched once per ID_BLOCK_SIZE tasks a thread creates. IDs are increasing per thread, but
+ * not across threads. They stay below 2^62, see task_id_to_uuid().
+ */
+
+void registry_add(tboard_t *t, task_t *task);
+/**
+ * registry_add() - Adds task to task registry. Called by task_add() and batch counterparts.
+ * @t:    tboard_t pointer to task board.
+ * @task: task being added to task board. Assigned an ID first if @task->id is 0.
+ * 
+ * Context: locks shard of @task->id in @t->reg_mutex.
+ */
+
+void registry_remove(tboard_t *t, task_t *task);
+/**
+ * registry_remove() - Removes task from task registry before it is released.
+ * @t:    tboard_t pointer to task board.
+ * @task: task that terminated or is discarded. Nothing is done if it is not registered.
+ * 
+ * Once this returns, task_cancel() no longer finds @task, so it may be released.
+ * 
+ * Context: locks shard of @task->id in @t->reg_mutex.
+ */
+
+void registry_discard(tboard_t *t, task_t *task);
+/**
+ * registry_discard() - Releases cancelled task instead of running it.
+ * @t:    tboard_t pointer to task board.
+ * @task: task with @task->cancelled set, taken out of a ready queue by an executor, or out of
+ *        the timer wheel by task_cancel().
+ * 
+ * Called by whoever holds the only reference to @task. Same as registry_detach() followed by
+ * registry_free().
+ */
+
+void registry_detach(tboard_t *t, task_t *task);
+/**
+ * registry_detach() - Releases everything of a cancelled task but its context.
+ * @t:    tboard_t pointer to task board.
+ * @task: cancelled task that will never be resumed.
+ * 
+ * Removes @task from the registry, releases the futures it spawned, completes its own and
+ * releases its concurrent task slot. Used by task_cancel() for a task waiting on a blocking
+ * remote task, whose context is freed by registry_free() once the response arrives.
+ */
+
+void registry_free(tboard_t *t, task_t *task);
+/**
+ * registry_free() - Frees user data, context and task_t of a cancelled task.
+ * @t:    tboard_t pointer to task board.
+ * @task: task released with registry_detach().
+ */
+
+///////////////////////////////////////////////
+///////////// Future Definitions //////////////
+///////////////////////////////////////////////
+
+/**
+ * task_future_t - Handle of a child task created by task_spawn()
+ * @tboard:    task board child task runs on
+ * @id:        ID of child task, may be passed to task_cancel()
+ * @completed: child task ran to completion, false if it was cancelled. Valid once joined
+ * @join:      join waiting on child task, set by task_join_all(). Exchanged for a sentinel
+ *             once child task terminates, by future_complete(), or once parent task is released
+ *             without joining it, by future_abandon()
+ * @owner:     task that spawned child task, NULL if it was spawned from outside a task
+ * @next:      next future in @owner->futures
+ * @prev:      previous future in @owner->futures, NULL if first
+ * 
+ * Allocated by task_spawn() and freed by task_join() or task_join_all(), so every future must
+ * be joined exactly once, by the task that spawned it. Should that task be cancelled or destroyed
+ * with the task board first, whichever of it and the child lets go of the future last frees it.
+ */
+typedef struct task_future_t {
+    tboard_t *tboard;
+    uint64_t id;
+    bool completed;
+    struct task_join_t *_Atomic join;
+    task_t *owner;
+    struct task_future_t *next;
+    struct task_future_t *prev;
+} task_future_t;
+
+/**
+ * task_join_t - Children a parked parent task waits for
+ * @pending: Number of references keeping @waiter parked: one per child that had not terminated
+ *           when it was joined, plus one held by @waiter until executor took it off its CPU
+ * @waiter:  Parent task, placed back in a ready queue by whoever drops the last reference
+ * 
+ * Lives on the coroutine stack of @waiter, in task_join_all().
+ */
+typedef struct task_join_t {
+    atomic_int pending;
+    task_t *waiter;
+} task_join_t;
+
+void future_complete(tboard_t *t, task_future_t *future, bool completed);
+/**
+ * future_complete() - Completes future of a child task that terminated or was discarded
+ * @t:         tboard_t pointer to task board.
+ * @future:    @task->future of child task
+ * @completed: true if child task ran to completion
+ * 
+ * If a parent joined @future already, drops its reference on the join, placing the parent
+ * back in a ready queue if it was the last one. @future must not be touched afterwards, as
+ * the parent may free it at any time. If the parent was released without joining it, @future
+ * is freed here.
+ */
+
+void future_abandon(task_t *task);
+/**
+ * future_abandon() - Lets go of futures of children @task spawned and will never join
+ * @task: task released without running to its end, or which terminated without joining
+ * 
+ * Frees futures of children that terminated already, and leaves the others to be freed by
+ * their child once it terminates (see future_complete()).
+ * 
+ * Context: Caller holds the only reference to @task, which is not running.
+ */
+
+void future_destroy(task_t *task);
+/**
+ * future_destroy() - Releases futures of @task as task board is destroyed
+ * @task: task being destroyed by task_destroy()
+ * 
+ * Abandons the futures @task spawned and completes its own, like future_complete(), except
+ * that a parent parked in task_join_all() whose last reference this drops is destroyed with
+ * task_destroy() instead of being placed back, as it would never run again.
+ * 
+ * Context: Only called on task board destruction, once executors are joined.
+ */
+
+bool future_park(task_t *task, task_join_t *join);
+/**
+ * future_park() - Parks task that yielded from task_join_all()
+ * @task: task that yielded with YIELD_JOIN, which executor just took off its CPU
+ * @join: join @task waits on, from its yield request
+ * 
+ * Drops the reference @task held on @join. Only now may children place
+ * @task back in a ready queue, as it is no longer running.
+ * 
+ * Context: Called by executor right after @task yielded.
+ * 
+ * Return: true if every child already terminated, so executor must reinsert @task itself.
+ */
+
 ///////////////////////////////////////////////
 
 void task_sequencer(tboard_t *tboard);
@@ -323,6 +965,17 @@ void task_sequencer(tboard_t *tboard);
 //////////// Executor Definitions ///////////////
 /////////////////////////////////////////////////
 
+void executor_spawn(tboard_t *t, pthread_t *thread, struct exec_t *exec);
+/**
+ * executor_spawn() - Creates task executor thread.
+ * @t:      tboard_t pointer to task board.
+ * @thread: where to store created thread.
+ * @exec:   executor argument, identifying executor to create.
+ * 
+ * Called by tboard_start() and tboard_add_secondary(). If executor is pinned (see
+ * tboard_set_affinity()), thread is created with that CPU affinity, so it never runs elsewhere.
+ */
+
 void *executor(void *arg);
 /** 
  * executor() - Task Executor (TExec); Thread function that handles task execution.
@@ -334,35 +987,191 @@ void *executor(void *arg);
  * 
  * If primary executor (pExecutor), this is the "main thread" of the tBoard. This executor
  * handles the primary queues. Essential tasks (tasks that have dependancies/deadlines) are
- * run by this executor. If there are no tasks pending in the primary ready queue, or if 
+ * run by this executor. Primary tasks placed by other threads are first moved from
+ * tBoard->pinbox into the primary ready queue. Scheduled tasks admitted by bid_processing() run ahead of
+ * the primary ready queue once due, in order of earliest deadline (see scheduler_next()), and pExecutor
+ * parks no longer than until the next one is due. If there are no tasks pending in the primary ready queue, or if 
  * there are tasks before earliest start time (EST), then pExecutor may run tasks from a
- * secondary ready queue, returning them to their original queue on task_yield(). Should
- * pExecutor not find a task to run, it will sleep on the primary condition variable 
- * tBoard->pCond (no_work).
- * 
- * If secondary executor (sExecutor), then tasks will be pulled only from respective
- * secondary ready queue. If there are no tasks in queue, sExecutor will sleep on 
- * respective condition variable tBoard->sCond[i].
- * 
- * Pulling tasks from ready queues has two phases:
- * * spin-block phase: (not implemented)
- * * *    to save overhead from frequent sleeping/waking on condition variables, executor
- * * *    will poll the ready queue for a preset number of iterations before entering the
- * * *    sleep-wake phase. Number of iterations is defined in SPIN_BLOCK_ITERATIONS macro.
+ * secondary ready queue, one at a time in rotating victim order, returning them to their original
+ * queue on task_yield(). Should
+ * pExecutor not find a task to run, it goes idle and eventually parks on tBoard->pparker.
+ * 
+ * If secondary executor (sExecutor), then tasks will be pulled from its own work-stealing
+ * deque tBoard->sdeque[i], after moving any tasks placed in its inbox tBoard->sinbox[i] by
+ * other threads into the deque. Yielded tasks are pushed back onto the deque and the oldest
+ * task is taken first, so tasks run round robin. Should its deque be empty, sExecutor steals half
+ * of what a sibling has in its deque (or inbox, if busy), up to STEAL_BATCH tasks, keeping the
+ * stolen tasks afterwards. Victims are tried in rotating order starting after the last one tried,
+ * and no lock is taken, so thieves never wait for each other or for the victim.
+ * If there are no tasks anywhere, sExecutor goes idle and eventually parks on tBoard->sparker[i].
+ * It is unparked when a task is placed in its inbox or when a busy sibling has surplus tasks
+ * to steal (see executor_wake_idle()).
+ * 
+ * An idle executor goes through three phases, restarting at the first whenever it finds a task:
+ * * spin-block phase:
+ * * *    to save overhead from frequent parking and unparking, executor polls the ready
+ * * *    queues, pausing the CPU between polls, for @tboard->idle_spin iterations.
+ * * *    Defaults to SPIN_BLOCK_ITERATIONS.
+ * 
+ * * yield phase:
+ * * *    executor keeps polling but yields its CPU between polls for @tboard->idle_yield
+ * * *    iterations, so other threads can run. Defaults to YIELD_BLOCK_ITERATIONS.
  * 
  * * sleep-wake phase:
- * * *    after spin-block phase, executor will sleep on condition variable defined above.
- * * *    Condition variable will signal when a task is added into respective ready queue.
+ * * *    executor parks (futex wait on Linux) until unparked by a thread placing work for it,
+ * * *    or until a remote task response it issued arrives (see remote_task_place()).
+ * 
+ * Number of times each phase is entered is counted per executor, see executor_print_stats().
  * 
  * Task executors will run as described indefinitely until task board is instructed to
- * terminate via special function tboard_kill().
+ * terminate via special function tboard_kill(). An sExecutor told to retire by
+ * tboard_remove_secondary() instead places every task it holds with the remaining executors
+ * and returns (see executor_retire()).
  * 
  * Context: Function will run in it's own thread, created in tboard_start().
- * Context: Function will sleep on condition variables described above
- * Context: Function will lock mutexes corresponding to tboard queues that it accesses
+ * Context: Function will park on parkers described above
+ * Context: Function will not lock to take tasks from its ready queues or injection queues
  * Context: Function will call history.c functions, locking tboard->hmutex
  */
 
+exec_t *executor_current(tboard_t *t);
+/**
+ * executor_current() - Returns executor argument of calling thread
+ * @t: tboard_t pointer of task board.
+ * 
+ * Used to determine whether the caller is one of the task executors of @t, for instance so
+ * that an sExecutor can push to its own deque without locking.
+ * 
+ * Return: exec_t pointer of calling executor thread, NULL if caller is not an executor of @t
+ */
+
+void executor_yield(int kind, void *target, uint64_t wake_at);
+/**
+ * executor_yield() - Yields currently run task with a request for its executor
+ * @kind:    one of the YIELD_* values, see yield_request_t
+ * @target:  object handed to executor, NULL if @kind takes none
+ * @wake_at: wake up time if @kind is YIELD_SLEEP, ignored otherwise
+ * 
+ * Stores request in @request of the calling executor and yields. Executor acts on it once
+ * task is off its CPU, so @target may live on the task's coroutine stack.
+ * 
+ * Context: Must be called from a task, on its executor thread.
+ */
+
+void executor_wake_primary(tboard_t *t);
+/**
+ * executor_wake_primary() - Unparks pExecutor if it is idle
+ * @t: tboard_t pointer of task board.
+ * 
+ * Called after making work available to pExecutor: placing a primary task, placing a secondary
+ * task pExecutor may steal, or queueing a remote task response for TSeq. Cheap when pExecutor is
+ * busy, as it only reads @t->pidle.
+ */
+
+void executor_wake(tboard_t *t, exec_t *exec);
+/**
+ * executor_wake() - Unparks executor @exec if it is idle
+ * @t:    tboard_t pointer of task board.
+ * @exec: executor to wake, NULL wakes pExecutor
+ * 
+ * Used as doorbell of remote task responses, waking the executor that issued the remote task.
+ * Should @exec be an sExecutor that is retired or not parked, pExecutor is woken instead, so a
+ * response issued from an sExecutor retired since is not left waiting in @t->msg_recv.
+ */
+
+bool executor_wake_secondary(tboard_t *t, int num);
+/**
+ * executor_wake_secondary() - Unparks sExecutor @num if it is idle
+ * @t:   tboard_t pointer of task board.
+ * @num: sExecutor to wake
+ * 
+ * Return: true if sExecutor @num was idle and has been unparked
+ */
+
+void executor_print_stats(tboard_t *t, FILE *fptr);
+/**
+ * executor_print_stats() - Prints idle policy counters of each executor
+ * @t:    tboard_t pointer of task board.
+ * @fptr: file to print to
+ * 
+ * Prints how many times each executor entered the spin, yield and park phase of its idle
+ * policy, how many tasks it stole in how many steals, and how many were stolen from each
+ * sExecutor. Should be called once executors have terminated, or values may be stale.
+ */
+
+bool executor_inbox_reserve(tboard_t *t, int num, int n);
+/**
+ * executor_inbox_reserve() - Counts tasks about to be pushed to inbox of sExecutor @num
+ * @t:   tboard_t pointer of task board.
+ * @num: sExecutor whose inbox @t->sinbox[num] tasks are pushed to
+ * @n:   number of tasks about to be pushed
+ * 
+ * Must be called before pushing to @t->sinbox[num]. Adds @n to @t->sinbox_len[num], then checks
+ * that sExecutor @num is still one of @t->sqs. A retiring sExecutor waits for its count to drop
+ * to zero before handing off its tasks, so tasks counted here are never stranded.
+ * 
+ * Return: true if caller must push its @n tasks, false if sExecutor @num is retiring, in which
+ *         case nothing was counted and caller must select another queue.
+ */
+
+void executor_retire(tboard_t *t, int num);
+/**
+ * executor_retire() - Hands tasks of a retiring sExecutor to remaining executors
+ * @t:   tboard_t pointer of task board.
+ * @num: calling sExecutor, told to retire by tboard_remove_secondary()
+ * 
+ * Waits for pushes to its inbox that began before it was retired, then places every task in its
+ * inbox, deque and feedback queues with task_place(), which only selects remaining sExecutors
+ * (or pExecutor once none are left). Thieves may steal from its deque meanwhile.
+ * 
+ * Context: Called by sExecutor @num itself before its thread returns.
+ */
+
+void *executor_autoscale(void *arg);
+/**
+ * executor_autoscale() - Autoscaler; Thread function adjusting number of sExecutors.
+ * @arg: tboard_t pointer of task board.
+ * 
+ * Every AUTOSCALE_INTERVAL ms, samples secondary queue depth (tasks in sExecutor deques and
+ * inboxes) and utilization (sExecutors idle or parked). If no sExecutor is idle and more than
+ * AUTOSCALE_QUEUE_DEPTH tasks per sExecutor are queued, adds an sExecutor. If an sExecutor has
+ * been idle with nothing queued for AUTOSCALE_QUIET_PERIODS intervals in a row, retires one.
+ * Stays within [@t->scale_min, @t->scale_max], moving into that range first.
+ * 
+ * Context: Runs in it's own thread, created by tboard_start() if enabled by tboard_set_autoscale().
+ *          Returns once task board shuts down, joined by tboard_destroy().
+ */
+
+void *executor_watchdog(void *arg);
+/**
+ * executor_watchdog() - Watchdog; Thread function flagging tasks that do not yield.
+ * @arg: tboard_t pointer of task board.
+ * 
+ * Checks the slice each executor is running several times per @t->slice_budget. A task running
+ * longer than the budget without yielding is reported with tboard_err(), attributed by the
+ * function name of its history entry, and recorded there (see history_record_overrun()). Its
+ * slice keeps being tracked until it returns, so history holds the longest overrun seen.
+ * 
+ * If @t->slice_quarantine is set, the sExecutor running it is quarantined: task placement stops
+ * selecting its queue and an idle sibling is woken to steal what is queued there. Quarantine is
+ * lifted by the sExecutor once the task yields or terminates. Tasks in lower feedback queues
+ * (see tboard_set_mlfq()) of a quarantined sExecutor wait for it. pExecutor is only reported,
+ * as primary tasks have nowhere else to run.
+ * 
+ * Context: Runs in it's own thread, created by tboard_start() if enabled by tboard_set_watchdog().
+ *          Returns once task board shuts down, joined by tboard_destroy().
+ */
+
+void executor_wake_idle(tboard_t *t, int skip);
+/**
+ * executor_wake_idle() - Wakes a sleeping sExecutor so it can steal work
+ * @t:    tboard_t pointer of task board.
+ * @skip: index of sExecutor not to wake (typically the caller), -1 for none
+ * 
+ * Called after pushing work that a busy executor cannot get to soon. Returns immediately if no
+ * sExecutor is idle, otherwise unparks the first idle sExecutor found.
+ */
+
 
 
 
@@ -373,12 +1182,13 @@ void *executor(void *arg);
 tboard_t* tboard_create(int secondary_queues);
 /**
  * tboard_create() - Creates task board object.
- * @secondary_queues: Number of secondary queues tboard should have.
+ * @secondary_queues: Number of secondary queues tboard should have. More can be added later, up to
+ *                    MAX_SECONDARIES (see tboard_add_secondary()).
  * 
  * This function allocates and initializes task board object.
  * 
  * Primary and secondary ready queues and wait queues are created and initialized.
- * Primary and secondary mutex and condition variables are initialized. tboard->status
+ * Primary and secondary executor parkers are initialized. tboard->status
  * will be set to 0, indicating that task board was created but has not started yet.
  * 
  * Context: Free allocated memory associated with task board object is freed in tboard_destroy()
@@ -444,8 +1254,7 @@ bool tboard_kill(tboard_t *t);
  * tboard_destroy() allowing program to terminate. 
  * 
  * Context: Executor threads stored in @t->primary and @t->secondary[] are canceled.
- *          As such, all @t->pmutex and @t->smutex[] are locked to signal @t->pcond
- *          and @t->scond[] respectively.
+ *          As such, @t->pparker and all @t->sparker[] are unparked.
  * Context: Sleeps on @t->tcond, signal occurs once all tasks are joined.
  * Context: @t->emutex is locked to initiate shutdown, effectively blocking tboard_destroy()
  *          from proceeding until after all tasks are joined. Once that occurs, it will signal
@@ -462,6 +1271,164 @@ bool tboard_kill(tboard_t *t);
 
 
 
+void tboard_set_idle_policy(tboard_t *t, int spin_iterations, int yield_iterations);
+/**
+ * tboard_set_idle_policy() - Sets how long idle executors spin and yield before parking.
+ * @t:                tboard_t pointer of task board.
+ * @spin_iterations:  Idle iterations spent polling with a CPU pause. Default SPIN_BLOCK_ITERATIONS
+ * @yield_iterations: Idle iterations spent polling with sched_yield() after spinning. Default
+ *                    YIELD_BLOCK_ITERATIONS
+ * 
+ * Spinning lowers wakeup latency of bursty work at the cost of CPU time. Setting both to 0 parks
+ * idle executors right away. Should be called before tboard_start().
+ */
+
+void tboard_set_placement(tboard_t *t, int policy);
+/**
+ * tboard_set_placement() - Sets how secondary tasks are assigned to secondary queues.
+ * @t:      tboard_t pointer of task board.
+ * @policy: One of the following
+ *          PLACEMENT_POWER_OF_TWO: Picks two secondary queues at random and places task in the
+ *                                  shorter one. Default policy (DEFAULT_PLACEMENT)
+ *          PLACEMENT_ROUND_ROBIN:  Cycles through secondary queues
+ *          PLACEMENT_LOCAL:        Tasks created by an sExecutor stay on its own queue, where it
+ *                                  can push without locking. Other callers use PLACEMENT_POWER_OF_TWO
+ * 
+ * Queue length is the number of tasks in an sExecutor's deque and inbox. It is read without
+ * locking so it is approximate. Work stealing still evens out queues after placement, the policy
+ * decides where work starts out. May be called at any time, including while the task board runs.
+ */
+
+bool tboard_set_affinity(tboard_t *t, int type, int num, const int *cpus, int ncpus);
+/**
+ * tboard_set_affinity() - Pins task executor to a CPU or list of CPUs.
+ * @t:     tboard_t pointer of task board.
+ * @type:  PRIMARY_EXEC for pExecutor, SECONDARY_EXEC for an sExecutor.
+ * @num:   sExecutor to pin if @type is SECONDARY_EXEC, may be one added later by tboard_add_secondary().
+ * @cpus:  CPU numbers executor may run on, each less than MAX_CPUS.
+ * @ncpus: Number of CPUs in @cpus. 0 removes pinning.
+ * 
+ * Must be called before tboard_start(), which creates the executor thread with this affinity.
+ * A pinned executor also allocates its secondary deque array, and fills its task and coroutine
+ * stack caches, from the executor thread itself before running any task. Under Linux's default
+ * first-touch policy, this places them on the NUMA node local to the executor's CPUs. Objects
+ * allocated later by the executor are placed likewise. Only supported on Linux.
+ * 
+ * Return: true if affinity was recorded, false if arguments are invalid, task board has started
+ *         or pinning is not supported.
+ */
+
+int tboard_add_secondary(tboard_t *t);
+/**
+ * tboard_add_secondary() - Adds an sExecutor and secondary ready queue.
+ * @t: tboard_t pointer of task board.
+ * 
+ * May be called while task board runs, in which case the new sExecutor is started right away,
+ * or before tboard_start(). Task placement selects the new queue as soon as this returns, and
+ * busy siblings are stolen from by it like by any other sExecutor. Pinning set beforehand with
+ * tboard_set_affinity() for this sExecutor applies.
+ * 
+ * Context: Locks @t->smutex. Joins thread of a previously retired sExecutor using this slot.
+ * 
+ * Return: number of the new sExecutor, -1 if MAX_SECONDARIES are running or task board is
+ *         shutting down.
+ */
+
+bool tboard_remove_secondary(tboard_t *t);
+/**
+ * tboard_remove_secondary() - Retires the most recently added sExecutor.
+ * @t: tboard_t pointer of task board.
+ * 
+ * Task placement stops selecting its queue right away. The sExecutor finishes the task it is
+ * running, places every task in its queues with the remaining executors (see executor_retire())
+ * and exits. Once no sExecutor is left, secondary tasks run on pExecutor. Retiring does not
+ * wait for this, the thread is joined when its slot is added again or by tboard_destroy().
+ * 
+ * Context: Locks @t->smutex.
+ * 
+ * Return: true if an sExecutor was retired, false if there is none or task board is not running.
+ */
+
+bool tboard_set_watchdog(tboard_t *t, uint64_t budget, bool quarantine);
+/**
+ * tboard_set_watchdog() - Flags tasks running too long without yielding.
+ * @t:          tboard_t pointer of task board.
+ * @budget:     Time (ns) a task may run between yields, 0 disables watchdog.
+ * @quarantine: true to stop placing tasks with an sExecutor while it runs a flagged task.
+ * 
+ * Must be called before tboard_start(), which then starts a watchdog thread (see
+ * executor_watchdog()). Executors then read the clock around every slice they run.
+ * 
+ * Return: true if watchdog was configured, false if task board has started.
+ */
+
+bool tboard_set_autoscale(tboard_t *t, int min, int max);
+/**
+ * tboard_set_autoscale() - Lets number of sExecutors follow load.
+ * @t:   tboard_t pointer of task board.
+ * @min: fewest sExecutors to keep, at least 1.
+ * @max: most sExecutors to run, at most MAX_SECONDARIES.
+ * 
+ * Must be called before tboard_start(), which then starts an autoscaler thread adding and
+ * retiring sExecutors by queue depth and utilization (see executor_autoscale()). Without it,
+ * the number of sExecutors only changes through tboard_add_secondary() and tboard_remove_secondary().
+ * 
+ * Return: true if autoscaling was enabled, false if arguments are invalid or task board has started.
+ */
+
+void tboard_set_mlfq(tboard_t *t, bool enable);
+/**
+ * tboard_set_mlfq() - Enables or disables multi-level feedback queues for secondary tasks.
+ * @t:      tboard_t pointer of task board.
+ * @enable: true to schedule secondary tasks by feedback queues. Default is DEFAULT_MLFQ
+ * 
+ * With feedback queues, each sExecutor keeps MLFQ_LEVELS levels of tasks. New tasks start at
+ * level 0, its work-stealing deque. A task that uses more than its level's CPU time allotment
+ * (MLFQ_QUANTUM, doubling at each level) without completing is demoted a level, while a task
+ * running a short slice is promoted if tasks of its function usually complete within the
+ * allotment of the level above (history_t @mean_t). sExecutor only runs a lower level once
+ * every level above it, and its siblings' deques, are empty, so short tasks are not stuck behind
+ * CPU-heavy ones. Every MLFQ_BOOST_INTERVAL ms, all tasks are moved back to level 0.
+ * 
+ * Demoted tasks stay on their sExecutor and are not stolen by siblings. May be called at any
+ * time, tasks already demoted still run after feedback queues are disabled.
+ */
+
+void tboard_set_stack_profile(tboard_t *t, bool enable);
+/**
+ * tboard_set_stack_profile() - Enables or disables stack usage profiling of every task.
+ * @t:      tboard_t pointer of task board.
+ * @enable: true to probe stack usage of every task. Default is DEFAULT_STACK_PROFILE
+ * 
+ * Without profiling, only the executions history_stack_size() picks to size stacks are probed.
+ * With profiling, every coroutine stack is painted by task_stack_paint() when it is created,
+ * whichever stack size class it has, and scanned by task_stack_scan() once its task terminates.
+ * Usage is recorded in a histogram of STACK_PROFILE_BUCKET byte buckets per task function, and
+ * history_print_records() prints mean, 99th percentile and maximum stack usage of each function.
+ * 
+ * Painting and scanning touch the whole stack, so tasks are slower to create and terminate.
+ * May be called at any time, tasks created before are profiled as they were created.
+ */
+
+void tboard_set_stack_sizing(tboard_t *t, bool enable);
+/**
+ * tboard_set_stack_sizing() - Enables or disables stack size classes picked from history.
+ * @t:      tboard_t pointer of task board.
+ * @enable: true to size coroutine stacks from history. Default is DEFAULT_STACK_SIZING
+ * 
+ * Disabled, every task gets a STACK_SIZE stack. Enabled, the stacks of the first executions of
+ * each task function, and then of some of them, are probed (see history_stack_size()), and other
+ * executions get the smallest stack size class that holds STACK_MARGIN times the deepest probe.
+ * 
+ * Probes cannot see every input, so a function whose depth varies may outgrow its class. The
+ * last STACK_GUARD bytes of every downsized stack are checked after each slice, and should they
+ * have been touched, the function goes back to STACK_SIZE for good (see history_pin_stack()).
+ * A guard only catches overruns that stop short of the end of the stack, so only enable sizing
+ * for functions whose stack depth does not depend on their input.
+ * 
+ * May be called at any time, tasks created before keep the stack they were created with.
+ */
+
 int tboard_get_concurrent(tboard_t *t);
 /**
  * tboard_get_concurrent() - Returns number of concurrently running tasks
@@ -470,11 +1437,22 @@ int tboard_get_concurrent(tboard_t *t);
  * returns number of currently running tasks in taskboard, in all queues/executors.
  * this number will always be less than or equal to MAX_TASKS macro.
  * 
- * Context: locks mutex @t->tmutex to access @t->task_count
- * 
  * Return: @t->task_count
  */
 
+int tboard_get_concurrent_approx(tboard_t *t);
+/**
+ * tboard_get_concurrent_approx() - Returns approximate number of concurrently running tasks
+ * @t:  tboard_t pointer of task board.
+ * 
+ * Sums the per-executor shards of the task count (exec_t @task_adds and @task_ends) and those
+ * of threads that are not executors. Shards are read without synchronization, so the result may
+ * be slightly off while tasks are being added or completed. Intended for monitoring and heuristics
+ * where an exact count is not needed.
+ * 
+ * Return: approximate number of concurrently running tasks, never negative
+ */
+
 void tboard_inc_concurrent(tboard_t *t);
 /**
  * tboard_inc_concurrent() - Increments number of concurrently running tasks
@@ -484,7 +1462,7 @@ void tboard_inc_concurrent(tboard_t *t);
  * checks whether or not MAX_TASKS has been exceeded. This should only be run when adding a new task
  * to any executor ready queue, in order to keep track of the number of unique tasks in all queues.
  * 
- * Context: locks mutex @t->tmutex to access @t->task_count, and increments it
+ * Context: atomically increments @t->task_count
  */
 
 void tboard_deinc_concurrent(tboard_t *t);
@@ -496,7 +1474,7 @@ void tboard_deinc_concurrent(tboard_t *t);
  * checks whether or not current value is zero. This should only be run when adding any task completes
  * in any executor to indicate that a unique task is being removed from the ready task queue pool.
  * 
- * Context: locks mutex @t->tmutex to access @t->task_count, and increments it
+ * Context: atomically decrements @t->task_count
  */
 
 
@@ -512,12 +1490,28 @@ int tboard_add_concurrent(tboard_t *t);
  * but will proceed anyways, logging any invalid values. It will return the new number of concurrently
  * running tasks, 0 on error.
  * 
- * Context: locks mutex @t->tmutex to access @t->task_count
+ * Context: compare-exchange loop on @t->task_count, never blocks
  * 
  * Return: 0    - On Error: Unable to increment, as incrementing would exceed MAX_TASKS 
  *         else - @t->task_count after incrementing
  */
 
+int tboard_reserve_concurrent(tboard_t *t, int n);
+/**
+ * tboard_reserve_concurrent() - Increments number of concurrently running tasks by up to @n
+ *                               without exceeding MAX_TASKS
+ * @t: tboard_t pointer of task board.
+ * @n: number of tasks to reserve
+ * 
+ * Batch counterpart of tboard_add_concurrent(). Reserves as many of the @n requested slots as
+ * are available in a single update. Every reserved slot must either be used by a task, which
+ * releases it on termination, or be given back with tboard_deinc_concurrent().
+ * 
+ * Context: compare-exchange loop on @t->task_count, never blocks
+ * 
+ * Return: number of slots reserved, between 0 and @n
+ */
+
 
 ////////////////////////////////////////////////
 ////////////// Task Functions //////////////////
@@ -530,7 +1524,10 @@ void remote_task_place(tboard_t *t, remote_task_t *rtask, bool send);
  * @rtask:  remote_task_t pointer of remote task.
  * @send:   boolean value indicating whether remote task is being sent or received.
  * 
- * Places remote task into appropriate queue in task board @t.
+ * Places remote task into appropriate queue in task board @t. Outgoing remote tasks signal
+ * @t->msg_cond for the MQTT adapter. Incoming responses ring the doorbell of @rtask->issuer:
+ * @t->msg_pending is incremented and the issuing executor is unparked if idle, so the response
+ * is handled as soon as an executor is free instead of on a polling interval.
  * 
  * Context: locks @t->msg_mutex
  */
@@ -558,6 +1555,8 @@ bool remote_task_create(tboard_t *t, char *message, void *response, size_t sizeo
  * the appropriate task ready queue. Otherwise, it will be placed in remote_task_t remote task
  * object that is placed in @t->msg_send message queue, returning context only once controller has 
  * responded and MQTT adapter has placed remote_task_t remote task object into @t->msg_recv message queue.
+ * remote_task_t is taken from @t->rtask_pool and handed to executor by pointer. A blocking one is
+ * returned to pool by this function once the response arrives, a non-blocking one by TSeq.
  * 
  * Context: Locks @t->msg_mutex
  * 
@@ -604,6 +1603,30 @@ bool blocking_task_create(tboard_t *t, function_t fn, int type, void *args, size
  * Function will only return once parent task has been resumed by executor after child task was issued.
  */
 
+int task_create_batch(tboard_t *t, function_t fn, int type, void **args, size_t sizeof_args, int n);
+/**
+ * task_create_batch() - Creates @n tasks running the same function, adding them to ready queues
+ *                       at once.
+ * @t:           tboard_t pointer of task board.
+ * @fn:          Task function with signature `void fn(void *)` as function_t to be executed.
+ * @type:        Task type. Value is PRIMARY_EXEC or SECONDARY_EXEC.
+ * @args:        Array of @n task arguments, @args[k] is passed to the k-th task. May be NULL,
+ *               in which case every task receives NULL.
+ * @sizeof_args: Size of each task argument. Should be non-zero only if @args[k] point to
+ *               alloc'd memory.
+ * @n:           Number of tasks to create.
+ * 
+ * Behaves like calling task_create() @n times, but reserves concurrent task slots, records
+ * history, pushes to each ready queue and wakes each executor once for the whole batch rather
+ * than once per task. Intended for fan-out of many tasks, for instance from a spawning task.
+ * 
+ * Should fewer than @n tasks be created (MAX_TASKS reached or coroutine creation failed), the
+ * tasks for the first arguments of @args are created, and the remaining arguments are not
+ * freed by the task board.
+ * 
+ * Return: number of tasks created, between 0 and @n
+ */
+
 bool task_create(tboard_t *t, function_t fn, int type, void *args, size_t sizeof_args);
 /**
  * task_create() - Creates task, adds to appropriate ready queue to be executed
@@ -620,7 +1643,7 @@ bool task_create(tboard_t *t, function_t fn, int type, void *args, size_t sizeof
  * 
  * Creates task to be run by task board and adds it to respective ready queue, dependent on
  * task type @type. Should a task have side effects, @type is expected to reflect this. Once added
- * to a ready queue, it will signal condition variable of relevant executor to indicate that a new task
+ * to a ready queue, it will unpark relevant executor if idle to indicate that a new task
  * has been added to the ready queue.
  * 
  * Task functions return on task completion. Data can be made available to task function by setting
@@ -640,16 +1663,222 @@ bool task_create(tboard_t *t, function_t fn, int type, void *args, size_t sizeof
  * Tasks created via task_create() are local tasks. Remote procedure tasks (RPC) can be issued by MQTT
  * and are sent in the form of a message, handled by msg_processor().
  * 
- * Context: Process context. Takes and releases task executor mutex (@t->pmutex, @t->smutex[] for 
- *          pExecutor and sExecutor)
- * Context: Process Context. Signal task executor condition variable (@t->pcond, @t->scond[] for 
- *          pExecutor and sExecutor)
+ * Context: Process Context. Unparks task executor receiving task if it is idle (@t->pparker,
+ *          @t->sparker[] for pExecutor and sExecutor)
  * 
  * Return:
  * * true   - task was added to task board successfully.
  * * false  - task was not added to task board.
  */
 
+uint64_t task_create_id(tboard_t *t, function_t fn, int type, void *args, size_t sizeof_args);
+/**
+ * task_create_id() - Creates task like task_create(), returning its ID.
+ * @t:           tboard_t pointer of task board.
+ * @fn:          Task function with signature `void fn(void *)` as function_t to be executed.
+ * @type:        Task type. Value is PRIMARY_EXEC or SECONDARY_EXEC.
+ * @args:        Task arguments made available to task function @fn.
+ * @sizeof_args: Size of task arguments passed. Should be non-zero only if @args points to
+ *               alloc'd memory.
+ * 
+ * The returned ID identifies the task until it terminates, and can be passed to task_cancel().
+ * IDs are never reused within a process, even across task boards (see registry_next_id()).
+ * 
+ * Context: Same as task_create()
+ * 
+ * Return: ID of task, or 0 if task was not added to task board.
+ */
+
+bool task_create_copy(tboard_t *t, function_t fn, int type, const void *args, size_t sizeof_args);
+/**
+ * task_create_copy() - Creates task like task_create(), with a copy of its arguments.
+ * @t:           tboard_t pointer of task board.
+ * @fn:          Task function with signature `void fn(void *)` as function_t to be executed.
+ * @type:        Task type. Value is PRIMARY_EXEC or SECONDARY_EXEC.
+ * @args:        Task arguments, copied before task_create_copy() returns. Remain owned by caller.
+ * @sizeof_args: Size of task arguments to copy.
+ * 
+ * Arguments of up to TASK_ARGS_INLINE bytes are copied into the task object itself, so the
+ * task costs no allocation besides its pooled task_t and stack. Larger arguments are copied
+ * to the heap and freed when task terminates. Either way task_get_args() returns the copy, and
+ * modifications to it are not seen by the caller.
+ * 
+ * Context: Same as task_create()
+ * 
+ * Return: true if task was added to task board, false otherwise.
+ */
+
+task_future_t *task_spawn(tboard_t *t, function_t fn, int type, void *args, size_t sizeof_args);
+/**
+ * task_spawn() - Creates child task like task_create(), returning a handle to join it by.
+ * @t:           tboard_t pointer of task board.
+ * @fn:          Task function with signature `void fn(void *)` as function_t to be executed.
+ * @type:        Task type. Value is PRIMARY_EXEC or SECONDARY_EXEC.
+ * @args:        Task arguments made available to task function @fn.
+ * @sizeof_args: Size of task arguments passed. Should be non-zero only if @args points to
+ *               alloc'd memory.
+ * 
+ * Unlike blocking_task_create(), the caller keeps running, so it may spawn many children that
+ * run in parallel on whichever executors task_place() picks, and wait for all of them with
+ * task_join_all(). Children deliver results through @args, which the caller may read once
+ * joined if @sizeof_args is 0.
+ * 
+ * Context: Same as task_create()
+ * 
+ * Futures spawned by a task belong to it: should it be cancelled, or the task board destroyed
+ * while it waits, they are released along with it. Futures spawned from outside a task must be
+ * handed to a task that joins them.
+ * 
+ * Return: future of child task, to be passed to task_join() or task_join_all() exactly once.
+ *         NULL if task was not added to task board.
+ */
+
+bool task_join(task_future_t *future);
+/**
+ * task_join() - Waits for a child task created by task_spawn() to terminate.
+ * @future: future returned by task_spawn(), freed by task_join().
+ * 
+ * Same as task_join_all() with a single future.
+ * 
+ * Return: true if child task ran to completion.
+ */
+
+bool task_join_all(task_future_t **futures, int n);
+/**
+ * task_join_all() - Waits for child tasks created by task_spawn() to terminate.
+ * @futures: futures returned by task_spawn(), freed by task_join_all(). NULL entries are skipped.
+ * @n:       number of futures in @futures
+ * 
+ * Must be called from the task that spawned the children, or any task for children spawned from
+ * outside a task. Registers with every child that has not terminated yet and
+ * yields. The calling task is parked, in no ready queue, until the last child terminates
+ * and places it back, so it costs no executor time while it waits. Returns without yielding
+ * if every child terminated already. Children that are cancelled count as terminated.
+ * 
+ * Return: true if every child task ran to completion, false if one was cancelled, a future was
+ *         NULL, or if not called from a task (in which case nothing is joined or freed).
+ */
+
+bool tboard_parallel_for(tboard_t *t, int64_t begin, int64_t end, int64_t grain, range_function_t fn, void *ctx);
+/**
+ * tboard_parallel_for() - Runs range function over a range of elements in parallel.
+ * @t:     tboard_t pointer of task board.
+ * @begin: first element of range.
+ * @end:   element after last element of range.
+ * @grain: most elements @fn handles between yields, and fewest a task splits off. 0 or less
+ *         to size it from history timings of @fn, aiming for PARALLEL_SLICE ns between yields.
+ * @fn:    range function with signature `void fn(int64_t begin, int64_t end, void *ctx)`, as
+ *         range_function_t. Generated by macro TBOARD_RANGE(fn).
+ * @ctx:   passed to every call of @fn.
+ * 
+ * The range is split lazily, by binary splitting: a task working through its range hands the
+ * upper half of what is left to a new secondary task with task_spawn() only when an sExecutor
+ * may be looking for work (one is parked, or the task's own sExecutor has nothing queued).
+ * Otherwise it keeps going @grain elements at a time, yielding in between. So a range costs a
+ * handful of tasks rather than one per element, and spreads over sExecutors as they run dry.
+ * Should the task board run out of task slots, ranges are simply not split. Every task joins
+ * the tasks it split off before terminating.
+ * 
+ * Context: May be called from a task, which runs the range itself and is parked while it waits.
+ *          Otherwise, the range starts on a new secondary task and the calling thread blocks
+ *          until it completes, or until task board is killed. Task board must be started.
+ *          Returning because task board was killed, tasks of the range may still run until
+ *          tboard_kill() returns, so @ctx must outlive that.
+ * 
+ * Return: true once every element was handled, false if task board refused the range, was not
+ *         running, or was killed before the range completed.
+ */
+
+bool tboard_parallel_reduce(tboard_t *t, int64_t begin, int64_t end, int64_t grain, range_function_t fn,
+                            tb_combine_f combine, void *ctx, void *acc, size_t acc_size);
+/**
+ * tboard_parallel_reduce() - Reduces a range of elements in parallel.
+ * @t:        tboard_t pointer of task board.
+ * @begin:    first element of range.
+ * @end:      element after last element of range.
+ * @grain:    as in tboard_parallel_for().
+ * @fn:       range function with signature `void fn(int64_t begin, int64_t end, void *ctx, void *acc)`,
+ *            accumulating elements into @acc. Generated by macro TBOARD_REDUCE(fn).
+ * @combine:  combines two accumulators, with signature `void combine(void *acc, const void *other, void *ctx)`.
+ *            Must be associative. Accumulators of lower parts of the range are passed as @acc.
+ * @ctx:      passed to every call of @fn and @combine.
+ * @acc:      accumulator of @acc_size bytes holding the identity of @combine, overwritten by result.
+ * @acc_size: size of accumulator.
+ * 
+ * Splits the range like tboard_parallel_for(). Every task accumulates its part into its own
+ * copy of the identity, and combines the accumulators of tasks it split off once joined.
+ * 
+ * Context: Same as tboard_parallel_for()
+ * 
+ * Return: true once every element was reduced into @acc, false if task board refused the range,
+ *         was not running, or was killed before the range completed. @acc is then left as is.
+ */
+
+void parallel_destroy(tboard_t *t);
+/**
+ * parallel_destroy() - Releases parallel loops whose root task never terminated.
+ * @t: tboard_t pointer of task board.
+ * 
+ * Called by tboard_destroy() once executors are joined. A thread still waiting in
+ * tboard_parallel_for() or tboard_parallel_reduce() is woken and returns false, and each loop
+ * is freed once that thread no longer needs it, along with every part it was split into.
+ */
+
+bool task_cancel(tboard_t *t, uint64_t id);
+/**
+ * task_cancel() - Cancels task, so it is never resumed again.
+ * @t:  tboard_t pointer of task board.
+ * @id: ID of task to cancel, as returned by task_create_id().
+ * 
+ * Finds task in the task registry and marks it as cancelled in constant time, wherever it
+ * waits: in a ready queue or injection queue, in the timer wheel, or on a blocking remote task
+ * or child task. Ready queues are lock-free or owned by a single executor and cannot unlink
+ * a task from their middle, so the task stays queued until it is taken out as usual, at which
+ * point it is discarded instead of run (see registry_discard()). Its user data is freed as
+ * if it had terminated, and it no longer counts against MAX_TASKS.
+ * 
+ * A task sleeping in the timer wheel is unlinked and released before this returns. So is a
+ * task waiting on a blocking remote task, except for its context, as the remote task may point
+ * into it: the context is freed once the response arrives, or with the task board.
+ * 
+ * A task that is running when cancelled finishes its current slice. Should it terminate
+ * within that slice it completes normally, otherwise it is discarded before it would resume.
+ * Blocking child tasks have no ID of their own; cancelling their parent discards the parent
+ * once the child terminates.
+ * 
+ * May be called from any thread, including from tasks.
+ * 
+ * Context: locks shard of @id in @t->reg_mutex, and @t->timer_mutex and @t->msg_mutex under it.
+ * 
+ * Return: true  - task was found and will not be resumed again
+ *         false - no task with @id exists (it terminated or was never added), or it was
+ *                 already cancelled
+ */
+
+void task_id_to_uuid(tboard_t *t, uint64_t id, char *dst);
+/**
+ * task_id_to_uuid() - Maps task ID to a uuid4 string, for use outside the task board.
+ * @t:   tboard_t pointer of task board.
+ * @id:  task ID, as returned by task_create_id() or found in remote_task_t @task_id.
+ * @dst: buffer of at least UUID4_LEN bytes, receives the NUL terminated string.
+ * 
+ * Task IDs are 64-bit integers within the task board, and only become uuid4 strings when they
+ * cross the wire, for instance when an MQTT adapter sends a remote task. The first half of the
+ * string is @t->uuid_node, random per task board, and the second half holds @id next to the
+ * uuid4 variant bits, so strings of different task boards do not collide and
+ * task_id_from_uuid() maps them back without any lookup.
+ */
+
+uint64_t task_id_from_uuid(tboard_t *t, const char *uuid);
+/**
+ * task_id_from_uuid() - Maps uuid4 string made by task_id_to_uuid() back to task ID.
+ * @t:    tboard_t pointer of task board.
+ * @uuid: uuid4 string, for instance received by an MQTT adapter.
+ * 
+ * Return: task ID, to pass to task_cancel() for instance, or 0 if @uuid is malformed or was
+ *         not made by task board @t.
+ */
+
 void task_place(tboard_t *t, task_t *task);
 /**
  * task_place() - Places task into ready queue
@@ -660,7 +1889,38 @@ void task_place(tboard_t *t, task_t *task);
  * the task is ready for adding, meaning that it is initialized and it's context is created. This
  * should only be used internally by task board to place a task in its appropriate ready queue.
  * 
- * Context: Locks mutex of appropriate ready queue before placing it 
+ * Context: Does not lock to place task. Locks sExecutor mutex only to wake it if it is asleep
+ */
+
+void task_place_batch(tboard_t *t, task_t **tasks, int n);
+/**
+ * task_place_batch() - Places several tasks into ready queues
+ * @t:     tboard_t pointer to task board.
+ * @tasks: array of task_t pointers to tasks
+ * @n:     number of tasks in @tasks
+ * 
+ * Batch counterpart of task_place(). Tasks are grouped by the ready queue the placement policy
+ * assigns them to, accounting for tasks of the batch already assigned, and each group is pushed
+ * onto its injection queue at once. Each executor receiving tasks is woken at most once.
+ * 
+ * Context: Same as task_place()
+ */
+
+int task_add_batch(tboard_t *t, task_t **tasks, int n);
+/**
+ * task_add_batch() - Adds several tasks to task board.
+ * @t:     tboard_t pointer to task board.
+ * @tasks: array of task_t pointers to tasks
+ * @n:     number of tasks in @tasks
+ * 
+ * Batch counterpart of task_add(). Reserves concurrent task slots once with
+ * tboard_reserve_concurrent(), records all tasks in history under one @t->hmutex acquisition
+ * and places them with task_place_batch().
+ * 
+ * Should fewer than @n slots be available, only the first tasks of @tasks are added and the
+ * rest remain owned by the caller.
+ * 
+ * Return: number of tasks added, the first that many tasks of @tasks
  */
 
 bool task_add(tboard_t *t, task_t *task);
@@ -672,15 +1932,16 @@ bool task_add(tboard_t *t, task_t *task);
  * Adds task to task board. This function is called internally by task_create() and other functions
  * that create tasks. Local tasks should be added by task_create() call.
  * 
+ * Assigns task an ID unless @task->id is already set, and adds it to the task registry so it
+ * may be cancelled with task_cancel().
+ * 
  * It is assumped that task_t pointers to a properly formatted task object.
  * 
- * Function determines which TExec ready queue task should be added to. It will lock the appropriate
- * TExec mutex and signal condition variable after adding to ready queue.
+ * Function determines which TExec ready queue task should be added to. It will unpark the
+ * appropriate TExec after adding to ready queue, should it be idle.
  * 
- * Context: Process context. Takes and releases task executor mutex (@t->pmutex, @t->smutex[] for 
- *          pExecutor and sExecutor)
- * Context: Process Context. Signal task executor condition variable (@t->pcond, @t->scond[] for 
- *          pExecutor and sExecutor)
+ * Context: Process Context. Unparks task executor receiving task if it is idle (@t->pparker,
+ *          @t->sparker[] for pExecutor and sExecutor)
  * 
  * Return:
  * * true   - task was added to task board successfully.
@@ -697,6 +1958,29 @@ void task_yield();
  * will be added to the back of the appropriate ready queue.
  */
 
+void task_sleep(uint64_t ns);
+/**
+ * task_sleep() - puts currently run task to sleep
+ * @ns: minimum time to sleep for, in nanoseconds
+ * 
+ * This should only be called by task function. Otherwise functionality is undefined.
+ * 
+ * Task is yielded and kept in the task board's timer wheel instead of a ready queue, so it
+ * costs no executor time while asleep. Once @ns has passed, it is returned to the appropriate
+ * ready queue via task_place(). Wake up is rounded up to the next TIMER_RESOLUTION tick.
+ */
+
+void task_yield_until(uint64_t deadline);
+/**
+ * task_yield_until() - yields currently run task until deadline
+ * @deadline: time to resume task at, as returned by timer_now()
+ * 
+ * This should only be called by task function. Otherwise functionality is undefined.
+ * 
+ * Like task_sleep(), but with an absolute wake up time. If @deadline has already passed,
+ * this behaves like task_yield().
+ */
+
 void *task_get_args();
 /**
  * task_get_args() - Gets @args passed to task_create on task creation
@@ -716,6 +2000,88 @@ void remote_task_destroy(remote_task_t *rtask);
  * Destroys remote task and any associated local tasks on task board destroy
  */
 
+context_desc task_desc_init(tboard_t *t, function_t fn, void *args, size_t stack_size);
+/**
+ * task_desc_init() - Creates coroutine description for task
+ * @t:          tboard_t pointer of task board the task will run on.
+ * @fn:         Task function as function_t.
+ * @args:       Task arguments, stored as coroutine user data.
+ * @stack_size: Stack size, one of the stack size classes STACK_MIN_SIZE << k for k below
+ *              STACK_CLASSES. 0 for STACK_SIZE.
+ * 
+ * Description allocates the coroutine context from @t->stack_pool through task_stack_alloc()
+ * and task_stack_free(), so every coroutine created on a task board must use a description
+ * created here.
+ * 
+ * Return: Coroutine description to be passed to mco_create()
+ */
+
+mco_result task_context_create(tboard_t *t, task_t *task, void *args);
+/**
+ * task_context_create() - Creates coroutine of task, with a stack sized from history
+ * @t:    tboard_t pointer of task board the task will run on.
+ * @task: task to create @task->ctx and @task->desc of. @task->fn must be set.
+ * @args: Task arguments, stored as coroutine user data.
+ * 
+ * Picks the stack size class of @task->fn with history_stack_size(), which also sets
+ * @task->hist. While a function is being probed, its tasks get a STACK_SIZE stack painted
+ * by task_stack_paint(), and the executor records the peak usage found by task_stack_scan()
+ * once they terminate. Other tasks get the smallest class that holds STACK_MARGIN times the
+ * largest peak seen for their function, guarded by task_stack_guard() if that is smaller than
+ * STACK_SIZE. Without tboard_set_stack_sizing(), every task gets STACK_SIZE.
+ * 
+ * Context: locks @t->hmutex
+ * 
+ * Return: result of mco_create()
+ */
+
+void *task_copy_args(task_t *task, const void *args, size_t sizeof_args);
+/**
+ * task_copy_args() - Copies task arguments, into the task object if they fit
+ * @task:        task the arguments are copied for. Sets @task->data_size.
+ * @args:        arguments to copy
+ * @sizeof_args: size of @args in bytes
+ * 
+ * Arguments of up to TASK_ARGS_INLINE bytes are copied into @task->args and @task->data_size
+ * is set to 0. Larger arguments are copied to the heap and @task->data_size is set to
+ * @sizeof_args, so they are freed when task terminates.
+ * 
+ * Return: pointer to pass to task_context_create() as @args, NULL if @args is NULL, @sizeof_args
+ *         is 0 or allocation failed
+ */
+
+void task_stack_paint(context_t ctx);
+/**
+ * task_stack_paint() - Fills unused part of a new coroutine's stack with a known pattern
+ * @ctx: coroutine that was created but not resumed yet
+ */
+
+size_t task_stack_scan(context_t ctx);
+/**
+ * task_stack_scan() - Finds peak stack usage of coroutine painted by task_stack_paint()
+ * @ctx: coroutine whose stack was painted
+ * 
+ * Stacks grow down, so the lowest word no longer holding the pattern marks the peak.
+ * 
+ * Return: peak stack usage in bytes
+ */
+
+void task_stack_guard(context_t ctx);
+/**
+ * task_stack_guard() - Fills last STACK_GUARD bytes of a new coroutine's stack with the pattern
+ * of task_stack_paint()
+ * @ctx: coroutine just created by mco_create()
+ */
+
+bool task_stack_check(context_t ctx);
+/**
+ * task_stack_check() - Checks guard painted by task_stack_guard() or task_stack_paint()
+ * @ctx: coroutine whose stack was guarded
+ * 
+ * Return: true if the guard is intact, false if task came within STACK_GUARD bytes of
+ *         overrunning its stack
+ */
+
 void task_destroy(task_t *task);
 /**
  * task_destroy() - Destroy tasks on completion
@@ -727,6 +2093,136 @@ void task_destroy(task_t *task);
  * Task destroys task function context, and then frees task arguments if indicated as allocated
  */
 
+////////////////////////////////////////////////
+////////////// Pool Functions //////////////////
+////////////////////////////////////////////////
+
+void pool_init(pool_t *p, size_t size, int capacity, int cache_size, bool zero);
+/**
+ * pool_init() - Initializes object pool
+ * @p:          pool to initialize
+ * @size:       size of objects allocated from pool
+ * @capacity:   maximum number of free objects pool will retain
+ * @cache_size: maximum number of free objects each executor will cache
+ * @zero:       if true, objects are zeroed on allocation like calloc()
+ * 
+ * Pools start empty, objects are only allocated on demand and retained once freed.
+ */
+
+void pool_destroy(pool_t *p);
+/**
+ * pool_destroy() - Releases all free objects retained by pool and destroys its mutex
+ * @p: pool to destroy
+ * 
+ * Objects still in use are not tracked by the pool, they must be released with free().
+ */
+
+void pool_cache_destroy(pool_cache_t *c);
+/**
+ * pool_cache_destroy() - Releases all objects held by executor cache
+ * @c: cache to destroy
+ * 
+ * Context: Must only be called once owning executor has terminated
+ */
+
+void pool_cache_prefill(pool_t *p, pool_cache_t *c, int n);
+/**
+ * pool_cache_prefill() - Fills executor cache with newly allocated objects
+ * @p: pool cache belongs to
+ * @c: cache of calling executor
+ * @n: number of objects to allocate, up to @p->cache_size objects are cached in total
+ * 
+ * Objects are allocated and written by the calling executor, so on Linux their pages are
+ * placed on the NUMA node it runs on. Used by pinned executors (see tboard_set_affinity()).
+ * 
+ * Context: Must only be called by executor owning @c
+ */
+
+void *pool_alloc(pool_t *p, pool_cache_t *c);
+/**
+ * pool_alloc() - Allocates zeroed object from pool
+ * @p: pool to allocate from
+ * @c: cache of calling executor, NULL if caller is not an executor
+ * 
+ * Takes object from @c, refilling it from @p if empty. If @c is NULL, object is taken from @p
+ * directly. Should pool be empty, object is allocated with malloc().
+ * 
+ * Context: Locks @p->mutex when @c is NULL or needs refilling
+ * 
+ * Return: Object of @p->size bytes, zeroed if @p->zero
+ */
+
+void pool_free(pool_t *p, pool_cache_t *c, void *obj);
+/**
+ * pool_free() - Returns object to pool
+ * @p:   pool object was allocated from
+ * @c:   cache of calling executor, NULL if caller is not an executor
+ * @obj: object to return
+ * 
+ * Object is placed in @c, spilling @p->batch objects to @p once @c exceeds @p->cache_size.
+ * Objects exceeding @p->capacity are released with free().
+ * 
+ * Context: Locks @p->mutex when @c is NULL or needs spilling
+ */
+
+task_t *task_alloc(tboard_t *t);
+/**
+ * task_alloc() - Allocates zeroed task_t from @t->task_pool, using cache of calling executor
+ * @t: tboard_t pointer of task board
+ */
+
+void task_free(tboard_t *t, task_t *task);
+/**
+ * task_free() - Returns task_t to @t->task_pool, using cache of calling executor
+ * @t:    tboard_t pointer of task board
+ * @task: task to return. Task's context and arguments must already be destroyed
+ */
+
+remote_task_t *remote_task_alloc(tboard_t *t);
+/**
+ * remote_task_alloc() - Allocates zeroed remote_task_t from @t->rtask_pool, using cache of calling executor
+ * @t: tboard_t pointer of task board
+ */
+
+void remote_task_free(tboard_t *t, remote_task_t *rtask);
+/**
+ * remote_task_free() - Returns remote_task_t to @t->rtask_pool, using cache of calling executor
+ * @t:     tboard_t pointer of task board
+ * @rtask: remote task to return
+ */
+
+void *task_stack_alloc(size_t size, void *allocator_data);
+/**
+ * task_stack_alloc() - Coroutine allocation callback, takes context from @t->stack_pool
+ * @size:           size of coroutine context and stack, must match one of @t->stack_pool
+ * @allocator_data: tboard_t pointer of task board
+ * 
+ * Set as malloc_cb of every coroutine description by task_desc_init(). Contexts taken from the
+ * pool are not zeroed, mco_init() resets everything it needs.
+ */
+
+void task_stack_free(void *ptr, void *allocator_data);
+/**
+ * task_stack_free() - Coroutine deallocation callback, returns context to @t->stack_pool
+ * @ptr:            coroutine context being destroyed, its size class is found from its stack size
+ * @allocator_data: tboard_t pointer of task board
+ * 
+ * Set as free_cb of every coroutine description by task_desc_init(), called by mco_destroy().
+ */
+
+void pool_print_stats(tboard_t *t, FILE *fptr);
+/**
+ * pool_print_stats() - Prints pool hits and misses to @fptr
+ * @t:    tboard_t pointer to task board
+ * @fptr: file pointer to print statistics to
+ * 
+ * Prints hits and misses of every executor cache, followed by totals per pool including
+ * allocations made from threads that are not executors.
+ * 
+ * Context: locks pool mutexes. Caches are read without locking, so values are only exact
+ *          once task board has been killed.
+ */
+
 //////////////////////////////////////////////////
 ////////////// Processor Definitions /////////////
 //////////////////////////////////////////////////
@@ -736,9 +2232,12 @@ void task_destroy(task_t *task);
  * @type: Message type
  * @subtype: Message subtype
  * @has_side_effects: Indicates if task has side effects.
- * @data: Data recieved from MQTT Adapter
+ * @data: Data recieved from MQTT Adapter. For TASK_EXEC, task_t of which only @fn is read
  * @user_data: Data passed to task, determined by MQTT Adapter.
  * @ud_allocd: Integer representing size of allocated memory pointed to by @user_data
+ * @args: Task arguments copied into task like task_create_copy(), used instead of @user_data
+ *        if @args_size is non-zero. Saves allocating @user_data for small arguments
+ * @args_size: Number of bytes of @args, at most TASK_ARGS_INLINE
  * 
  * msg_t objects are created by MQTT Adapter when message is recieved, and is used to pass message
  * information appropriated to task board.
@@ -750,6 +2249,8 @@ typedef struct {
     void *data; // must be castable to task_t or bid_t
     void *user_data;
     size_t ud_allocd; // whether user_data was alloc'd
+    _Alignas(max_align_t) unsigned char args[TASK_ARGS_INLINE];
+    size_t args_size;
 } msg_t;
 
 /**
@@ -757,15 +2258,20 @@ typedef struct {
  * 
  * bid_t objects are created by Redis adapter.
  * 
- * Current values are placeholders, as implementation specifications have not been issued.
- * 
- * TODO: Implement.
+ * @type:      Task type, PRIMARY_EXEC or PRIORITY_EXEC. Only primary tasks are scheduled
+ * @EST:       Earliest start time of task, in milliseconds since task board creation (see scheduler_time())
+ * @LST:       Latest start time of task. Task meets its deadline if it starts by then
+ * @data:      task_t to schedule, with @fn set. Only @fn is read by bid_processing(), so owned by caller
+ * @user_data: Task arguments, passed to task like task_create() @args
+ * @ud_allocd: Size of @user_data if allocated, in which case it is freed when task ends
  */
 typedef struct {
     int type;
     int EST;
     int LST;
     void *data;
+    void *user_data;
+    size_t ud_allocd;
 } bid_t;
 
 bool msg_processor(tboard_t *t, msg_t *msg); // when a message is received, it interprets message and adds to respective queue
@@ -802,11 +2308,139 @@ bool data_processor(tboard_t *t, msg_t *msg); // when data is received, it inter
 
 bool bid_processing(tboard_t *t, bid_t *bid); // missing requirements
 /**
- * bid_processing() - Processes remote schedule changes issued by MQTT
+ * bid_processing() - Admits bid issued by MQTT into primary deadline schedule
  * @t:   tboard_t pointer to task board.
- * @bid: bid issued remotely that dictates schedule changes
+ * @bid: bid issued remotely, describing task and its start window
  * 
- * TODO: Need requirements and implementation
+ * Implemented in scheduler.c. Creates a primary task from @bid and hands it to the scheduler,
+ * which runs it on pExecutor in order of earliest LST, no earlier than its EST. Bids whose LST
+ * has already passed, or whose EST is after their LST, are rejected without creating a task
+ * and counted in @t->sched_rejected. Rejected bids will never be admitted, so they must not be
+ * returned to the message queue.
+ * 
+ * Context: Safe to call from any thread.
+ * 
+ * Return: true  - bid was admitted
+ *         false - bid was rejected, is invalid, or task board is at MAX_TASKS
+ */
+
+void scheduler_init(tboard_t *t);
+/**
+ * scheduler_init() - Initializes primary deadline scheduler of task board.
+ * @t: tboard_t pointer to task board.
+ * 
+ * Called by tboard_create(), which also sets the time base of bid EST and LST.
+ */
+
+void scheduler_destroy(tboard_t *t);
+/**
+ * scheduler_destroy() - Destroys scheduled tasks that have not completed.
+ * @t: tboard_t pointer to task board.
+ * 
+ * Called by tboard_destroy() once executors have been joined.
+ */
+
+int scheduler_time(tboard_t *t);
+/**
+ * scheduler_time() - Current time of task board scheduler.
+ * @t: tboard_t pointer to task board.
+ * 
+ * Return: milliseconds since @t was created. Bid EST and LST are expressed in this time base.
+ */
+
+task_t *scheduler_next(tboard_t *t);
+/**
+ * scheduler_next() - Picks next scheduled task for pExecutor to run.
+ * @t: tboard_t pointer to task board.
+ * 
+ * Moves newly admitted tasks into the deadline heap, then drops any task that has not started
+ * and whose LST has passed, counting a deadline miss. If the task with earliest LST is due
+ * (its EST has arrived) it is removed from the heap and returned, counting a deadline hit if
+ * this is its first run. Tasks with later deadlines are not run ahead of it even if due.
+ * 
+ * Context: Only called by pExecutor.
+ * 
+ * Return: task to run, NULL if no scheduled task is due.
+ */
+
+void scheduler_place(tboard_t *t, task_t *task);
+/**
+ * scheduler_place() - Places scheduled task into deadline schedule.
+ * @t:    tboard_t pointer to task board.
+ * @task: task admitted by bid_processing(), with @task->scheduled set.
+ * 
+ * Called by task_place() for scheduled tasks, so yielded and resumed scheduled tasks keep their
+ * place in the schedule. pExecutor pushes to the heap directly, any other thread pushes to
+ * @t->sched_inbox and wakes pExecutor.
+ */
+
+int scheduler_wait(tboard_t *t);
+/**
+ * scheduler_wait() - Time until next scheduled task is due.
+ * @t: tboard_t pointer to task board.
+ * 
+ * Used by pExecutor to bound how long it parks.
+ * 
+ * Context: Only called by pExecutor.
+ * 
+ * Return: milliseconds until EST of task with earliest LST, 0 if a scheduled task is due or has
+ *         just been admitted, -1 if there are no scheduled tasks.
+ */
+
+void mlfq_feedback(tboard_t *t, task_t *task, int slice, struct exec_t *exec);
+/**
+ * mlfq_feedback() - Adjusts feedback queue level of a secondary task after it yields.
+ * @t:     tboard_t pointer to task board.
+ * @task:  yielded secondary task.
+ * @slice: CPU time @task just ran for.
+ * @exec:  sExecutor that ran @task, whose demotion/promotion counts are updated.
+ * 
+ * Does nothing unless feedback queues are enabled (see tboard_set_mlfq()). Not called for
+ * slices pExecutor runs of a borrowed secondary task.
+ */
+
+void mlfq_place(tboard_t *t, int num, task_t *task);
+/**
+ * mlfq_place() - Places secondary task at its feedback queue level of sExecutor @num.
+ * @t:    tboard_t pointer to task board.
+ * @num:  sExecutor calling, which owns the queues.
+ * @task: task to place. Level 0 is the sExecutor's deque.
+ * 
+ * Used for every task sExecutor @num takes in, whether it yielded there, was stolen, or
+ * arrived through its injection queue, so a demoted task keeps its level wherever it goes.
+ */
+
+void mlfq_age(tboard_t *t, int num, struct exec_t *exec);
+/**
+ * mlfq_age() - Moves all tasks of sExecutor @num back to level 0 every MLFQ_BOOST_INTERVAL ms.
+ * @t:    tboard_t pointer to task board.
+ * @num:  sExecutor calling, which owns the queues.
+ * @exec: executor argument of sExecutor @num, whose boost count is updated.
+ * 
+ * Called by sExecutor at each iteration. Does nothing unless feedback queues are enabled.
+ */
+
+task_t *mlfq_next(tboard_t *t, int num);
+/**
+ * mlfq_next() - Takes next task from lower feedback queue levels of sExecutor @num.
+ * @t:   tboard_t pointer to task board.
+ * @num: sExecutor calling, which owns the queues.
+ * 
+ * Return: task from highest non-empty level below level 0, NULL if there is none.
+ */
+
+bool mlfq_has_work(tboard_t *t, int num);
+/**
+ * mlfq_has_work() - Checks lower feedback queue levels of sExecutor @num for tasks.
+ * @t:   tboard_t pointer to task board.
+ * @num: sExecutor calling, which owns the queues.
+ */
+
+void scheduler_print_stats(tboard_t *t, FILE *fptr);
+/**
+ * scheduler_print_stats() - Prints bid admission and deadline hit/miss counts.
+ * @t:    tboard_t pointer to task board.
+ * @fptr: file to print to.
  */
 
 
@@ -824,6 +2458,20 @@ bool bid_processing(tboard_t *t, bid_t *bid); // missing requirements
  * @yields:      total number of yields for all executions (incremented at each yield)
  * @executions:  number of exections
  * @completions: number of complete executions
+ * @overruns:    number of slices flagged by watchdog for exceeding slice budget
+ * @max_slice:   longest slice (ns) seen by watchdog while flagged
+ * @stack_runs:  number of coroutines created for this function, see history_stack_size()
+ * @stack_probes: number of probed executions that completed
+ * @stack_peak:  largest peak stack usage (bytes) of probed executions
+ * @stack_size:  stack size class non-probed executions get, 0 until first probe completes
+ * @stack_pinned: an execution touched the guard of its downsized stack, so every execution gets
+ *               STACK_SIZE from then on (see history_pin_stack())
+ * @stack_profiled: number of executions recorded in @stack_hist
+ * @stack_total: sum of stack usage (bytes) of executions recorded in @stack_hist
+ * @stack_hist:  histogram of stack usage, STACK_PROFILE_BUCKET bytes per bucket. Allocated once
+ *               first execution is recorded while tboard_set_stack_profile() is enabled
+ * @range_iters: number of elements range function @fn_name handled in tboard_parallel_for()
+ * @range_time:  time (ns) range function @fn_name spent on @range_iters elements
  * 
  * This type is handled internally by history.c implementation. A pointer must be present in
  * tboard_t task board object to serve as the head of the hash table. Pointers present in
@@ -838,6 +2486,18 @@ typedef struct history_t {
     double yields;
     int executions;
     int completions;
+    int overruns;
+    uint64_t max_slice;
+    long stack_runs;
+    int stack_probes;
+    size_t stack_peak;
+    size_t stack_size;
+    bool stack_pinned;
+    long stack_profiled;
+    uint64_t stack_total;
+    long *stack_hist;
+    uint64_t range_iters;
+    uint64_t range_time;
     UT_hash_handle hh;
 } history_t;
 
@@ -859,6 +2519,64 @@ void history_record_exec(tboard_t *t, task_t *task, history_t **hist);
  * Context: locks @t->hmutex in order to modify hash table
  */
 
+size_t history_stack_size(tboard_t *t, task_t *task, int n);
+/**
+ * history_stack_size() - Picks coroutine stack size for next executions of a task function
+ * @t:    tboard_t pointer to task board
+ * @task: task about to get a coroutine. Sets @task->hist, and @task->stack_probe if the
+ *        stack is to be probed
+ * @n:    number of tasks of @task->fn about to be created that share the result
+ * 
+ * Returns STACK_SIZE unless tboard_set_stack_sizing() is enabled and @task->fn was not pinned
+ * by history_pin_stack(). Until STACK_PROBE_RUNS executions of @task->fn were probed, and then
+ * for one in STACK_PROBE_INTERVAL executions, the stack is probed and STACK_SIZE is returned.
+ * Otherwise the stack size class recorded in history is returned, and @task->stack_guard is
+ * set if it is smaller than STACK_SIZE. Stacks are probed regardless if
+ * tboard_set_stack_profile() is enabled.
+ * 
+ * Context: locks @t->hmutex in order to access hash table
+ * 
+ * Return: stack size to pass to task_desc_init()
+ */
+
+int64_t history_range_grain(tboard_t *t, const char *fn_name);
+/**
+ * history_range_grain() - Picks grain size of a range function from its history
+ * @t:       tboard_t pointer to task board
+ * @fn_name: name of range function passed to tboard_parallel_for()
+ * 
+ * Context: locks @t->hmutex in order to access hash table
+ * 
+ * Return: number of elements that take about PARALLEL_SLICE ns, going by time per element
+ *         recorded by history_record_range(). 1 if nothing was recorded yet
+ */
+
+void history_record_range(tboard_t *t, const char *fn_name, uint64_t iters, uint64_t ns);
+/**
+ * history_record_range() - Records time a range function took in history hash table
+ * @t:       tboard_t pointer to task board
+ * @fn_name: name of range function passed to tboard_parallel_for()
+ * @iters:   number of elements handled
+ * @ns:      time spent handling them
+ * 
+ * Context: locks @t->hmutex in order to modify hash table
+ */
+
+void history_record_batch(tboard_t *t, task_t **tasks, int n);
+/**
+ * history_record_batch() - Record creation of a batch of tasks in history hash table
+ * @t:     tboard_t pointer to task board
+ * @tasks: array of task_t pointers of newly created tasks
+ * @n:     number of tasks in @tasks
+ * 
+ * Equivalent to calling history_record_exec() on each task of @tasks and incrementing
+ * executions of the returned entry, but @t->hmutex is taken once for the whole batch and
+ * the hash table is only searched when function name changes between consecutive tasks.
+ * Sets @hist of every task in @tasks.
+ * 
+ * Context: locks @t->hmutex in order to modify hash table
+ */
+
 void history_fetch_exec(tboard_t *t, function_t *func, history_t **hist);
 /**
  * history_fetch_exec() - Fetch history hash table entry corresponding to function_t @func.
@@ -889,6 +2607,27 @@ void history_destroy(tboard_t *t);
  * Context: locks @t->hmutex in order to destroy hash table
  */
 
+void history_pin_stack(tboard_t *t, history_t *hist);
+/**
+ * history_pin_stack() - Gives every later execution of a task function a STACK_SIZE stack
+ * @t:    tboard_t pointer to task board
+ * @hist: history entry of task whose stack guard was touched, see task_stack_check()
+ * 
+ * Context: locks @t->hmutex in order to modify hash table entry
+ */
+
+void history_record_overrun(tboard_t *t, history_t *hist, uint64_t slice, bool flagged);
+/**
+ * history_record_overrun() - Records slice exceeding watchdog slice budget
+ * @t:       tboard_t pointer to task board
+ * @hist:    history entry of task running the slice
+ * @slice:   time (ns) slice has been running so far
+ * @flagged: true if slice was just flagged, counting it in @hist->overruns. Otherwise slice was
+ *           flagged before and only @hist->max_slice is updated
+ * 
+ * Context: locks @t->hmutex in order to modify hash table entry
+ */
+
 void history_save_to_disk(tboard_t *t, FILE *fptr);
 /**
  * history_save_to_disk() - Saves task board history to disk
@@ -915,6 +2654,8 @@ void history_print_records(tboard_t *t, FILE *fptr);
  * 
  * "task 'func_name' completed %d/%d times, yielding %ld times with mean execution time %ld"\
  * 
+ * Functions flagged by watchdog get a second line with their overrun count and longest slice.
+ * 
  * Context: locks @t->hmutex in order to access hash table
  */
 
@@ -0,0 +1,161 @@
+/**
+ * Test 10: Deadline scheduler. In this test, a bidding thread issues bids the way MQTT
+ * would, each with a start window [EST, LST], while primary tasks keep pExecutor busy
+ *
+ * bidding thread - Issues BID_TASKS bids with EST up to BID_SPREAD ms ahead and a start window of
+ *                  BID_WINDOW ms, followed by LATE_BIDS bids whose LST has already passed
+ * deadline_task() - Scheduled task, yields a few times and then exits
+ * busy_task() - Primary task that yields BUSY_YIELDS times, competing with scheduled tasks
+ *
+ * Every late bid should be rejected, and every admitted bid should either hit or miss its deadline.
+ */
+#include "tests.h"
+#ifdef TEST_10
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BID_TASKS (NUM_TASKS * 10)
+#define LATE_BIDS 10
+#define BID_SPREAD 200 // ms
+#define BID_WINDOW 20 // ms
+#define BUSY_TASKS 10
+#define BUSY_YIELDS 10000
+
+int completion_count = 0;
+int busy_count = 0;
+int admitted = 0;
+bool bidding_complete = false;
+
+clock_t test_time, kill_time;
+pthread_t bidder;
+
+void deadline_task(context_t ctx);
+void busy_task(context_t ctx);
+void *bidding_thread(void *args);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    for (int i=0; i<BUSY_TASKS; i++)
+        task_create(tboard, TBOARD_FUNC(busy_task), PRIMARY_EXEC, NULL, 0);
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\t%d/%d bids admitted, %d scheduled tasks completed, %d/%d busy tasks completed.\n",
+        admitted, BID_TASKS + LATE_BIDS, completion_count, busy_count, BUSY_TASKS);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&bidder, NULL, bidding_thread, tboard);
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(bidder, NULL);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *bidding_thread(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    task_t task = {0};
+    task.fn = TBOARD_FUNC(deadline_task);
+    bid_t bid = {.type = PRIMARY_EXEC, .data = &task};
+
+    for (int i=0; i<BID_TASKS; i++) {
+        bid.EST = scheduler_time(t) + rand() % BID_SPREAD;
+        bid.LST = bid.EST + BID_WINDOW;
+        bid.user_data = (void *)(intptr_t)i;
+        if (bid_processing(t, &bid))
+            increment_count(&admitted);
+        if (i % NUM_TASKS == 0)
+            fsleep(0.01);
+    }
+    for (int i=0; i<LATE_BIDS; i++) { // LST has passed, these must be rejected
+        bid.EST = 0;
+        bid.LST = scheduler_time(t) - 1;
+        if (bid_processing(t, &bid))
+            increment_count(&admitted);
+    }
+    bidding_complete = true;
+    return NULL;
+}
+
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all admitted bids either ran or were dropped, we kill task board
+        if (bidding_complete && read_count(&busy_count) >= BUSY_TASKS
+            && read_count(&completion_count) + atomic_load(&(t->sched_misses)) >= read_count(&admitted)) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== SCHEDULER STATISTICS ===========\n");
+            scheduler_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+void deadline_task(context_t ctx)
+{
+    (void)ctx;
+    long x = (intptr_t)task_get_args();
+    for (int i=0; i<3; i++) {
+        x = x * 31 + i;
+        task_yield();
+    }
+    (void)x;
+    increment_count(&completion_count);
+}
+
+void busy_task(context_t ctx)
+{
+    (void)ctx;
+    for (int i=0; i<BUSY_YIELDS; i++)
+        task_yield();
+    increment_count(&busy_count);
+}
+
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * Test 11: Timer wheel. In this test, many tasks sleep for a while several times, instead of
+ * calling task_yield() in a loop until enough time has passed
+ *
+ * sleeping_task() - Sleeps SLEEP_ROUNDS times for up to MAX_SLEEP_MS with task_sleep(), recording
+ *                   how late it was woken up
+ * deadline_task() - Primary task that wakes up at fixed deadlines with task_yield_until(), the
+ *                   last one far enough ahead to cascade down the timer wheel
+ *
+ * Each task should only yield once per sleep, and executors should park while every task sleeps.
+ */
+#include "tests.h"
+#ifdef TEST_11
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SLEEP_TASKS (NUM_TASKS * 10)
+#define SLEEP_ROUNDS 5
+#define MAX_SLEEP_MS 50
+#define DEADLINES 3
+#define LONG_DEADLINE_MS 500
+
+int completion_count = 0;
+int sleep_count = 0;
+uint64_t late_total = 0, late_max = 0;
+
+clock_t test_time, kill_time;
+
+void sleeping_task(context_t ctx);
+void deadline_task(context_t ctx);
+
+void record_lateness(uint64_t late)
+{
+    pthread_mutex_lock(&count_mutex);
+    sleep_count++;
+    late_total += late;
+    if (late > late_max)
+        late_max = late;
+    pthread_mutex_unlock(&count_mutex);
+}
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    task_create(tboard, TBOARD_FUNC(deadline_task), PRIMARY_EXEC, NULL, 0);
+    for (int i=0; i<SLEEP_TASKS; i++)
+        task_create(tboard, TBOARD_FUNC(sleeping_task), SECONDARY_EXEC, (void *)(intptr_t)i, 0);
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\t%d/%d tasks completed, %d sleeps woke up %.3f ms late on average, %.3f ms at most.\n",
+        completion_count, SLEEP_TASKS + 1, sleep_count, (sleep_count > 0) ? late_total / 1e6 / sleep_count : 0.0, late_max / 1e6);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all tasks completed, we kill task board
+        if (read_count(&completion_count) >= SLEEP_TASKS + 1) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+void sleeping_task(context_t ctx)
+{
+    (void)ctx;
+    long n = (intptr_t)task_get_args();
+    for (int i=0; i<SLEEP_ROUNDS; i++) {
+        uint64_t ns = (uint64_t)((n * 7 + i * 13) % MAX_SLEEP_MS + 1) * 1000000;
+        uint64_t start = timer_now();
+        task_sleep(ns);
+        record_lateness(timer_now() - start - ns);
+    }
+    increment_count(&completion_count);
+}
+
+void deadline_task(context_t ctx)
+{
+    (void)ctx;
+    uint64_t start = timer_now();
+    for (int i=1; i<=DEADLINES; i++) {
+        uint64_t deadline = start + (uint64_t)i * LONG_DEADLINE_MS / DEADLINES * 1000000;
+        task_yield_until(deadline);
+        uint64_t now = timer_now();
+        assert(now >= deadline);
+        record_lateness(now - deadline);
+    }
+    increment_count(&completion_count);
+}
+
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * Test 12: Multi-level feedback queues. In this test, short tasks issued from a separate thread,
+ * as a controller would, compete with CPU-heavy secondary tasks
+ *
+ * heavy_task() - Burns HEAVY_SLICE_MS of CPU time between yields, HEAVY_ROUNDS times
+ * napping_task() - Burns HEAVY_SLICE_MS of CPU time between sleeps of NAP_MS, HEAVY_ROUNDS times
+ * short_task() - Yields a couple of times, then records the time since it was issued
+ * issuing thread - Issues SHORT_TASKS short tasks, one every ISSUE_INTERVAL_MS
+ *
+ * Napping tasks are demoted like heavy tasks, but return through the timer wheel and injection
+ * queues. Each time one wakes up, it checks that no demoted task sits in its sExecutor's deque.
+ *
+ * Set MLFQ_ENABLED to 0 to compare short task latency without feedback queues.
+ */
+#include "tests.h"
+#ifdef TEST_12
+
+#include "../tboard.h"
+#include "../queue/deque.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MLFQ_ENABLED 1
+#define HEAVY_TASKS (SECONDARY_EXECUTORS * 8)
+#define HEAVY_ROUNDS 100
+#define HEAVY_SLICE_MS 2
+#define NAPPING_TASKS (SECONDARY_EXECUTORS * 4)
+#define NAP_MS 1
+#define SHORT_TASKS NUM_TASKS
+#define ISSUE_INTERVAL_MS 5
+
+int heavy_count = 0;
+int short_count = 0;
+int napping_count = 0;
+int misplaced_count = 0; // demoted tasks napping tasks found in a deque
+uint64_t latency_total = 0, latency_max = 0;
+
+clock_t test_time, kill_time;
+pthread_t issuer;
+
+void heavy_task(context_t ctx);
+void napping_task(context_t ctx);
+void short_task(context_t ctx);
+void *issuing_thread(void *args);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    for (int i=0; i<HEAVY_TASKS; i++)
+        task_create(tboard, TBOARD_FUNC(heavy_task), SECONDARY_EXEC, NULL, 0);
+    for (int i=0; i<NAPPING_TASKS; i++)
+        task_create(tboard, TBOARD_FUNC(napping_task), SECONDARY_EXEC, NULL, 0);
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\tFeedback queues %s. %d/%d heavy tasks completed, %d/%d short tasks completed.\n",
+        MLFQ_ENABLED ? "enabled" : "disabled", heavy_count, HEAVY_TASKS, short_count, SHORT_TASKS);
+    printf("\t%d/%d napping tasks completed, %d demoted tasks were found in a deque.\n",
+        napping_count, NAPPING_TASKS, misplaced_count);
+    printf("\tShort task latency: %.3f ms on average, %.3f ms at most.\n",
+        (short_count > 0) ? latency_total / 1e6 / short_count : 0.0, latency_max / 1e6);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+    assert(misplaced_count == 0);
+
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    tboard_set_mlfq(tboard, MLFQ_ENABLED);
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&issuer, NULL, issuing_thread, tboard);
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(issuer, NULL);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *issuing_thread(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    struct timespec interval = {.tv_sec = 0, .tv_nsec = ISSUE_INTERVAL_MS * 1000000};
+    for (int i=0; i<SHORT_TASKS; i++) {
+        uint64_t issued = timer_now(); // copied into task, nothing to free
+        task_create_copy(t, TBOARD_FUNC(short_task), SECONDARY_EXEC, &issued, sizeof(uint64_t));
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all tasks completed, we kill task board
+        if (read_count(&heavy_count) >= HEAVY_TASKS && read_count(&napping_count) >= NAPPING_TASKS && read_count(&short_count) >= SHORT_TASKS) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+void heavy_task(context_t ctx)
+{
+    (void)ctx;
+    for (int i=0; i<HEAVY_ROUNDS; i++) {
+        uint64_t until = timer_now() + HEAVY_SLICE_MS * 1000000;
+        while (timer_now() < until)
+            ; // burn CPU
+        task_yield();
+    }
+    increment_count(&heavy_count);
+}
+
+static int count_misplaced(tboard_t *t)
+{
+    // we run on the sExecutor owning the deque, so its bottom and array do not change under us.
+    // A task still queued once its level is read (top has not passed it) was queued at that level
+    exec_t *exec = executor_current(t);
+    if (exec == NULL || exec->type != SECONDARY_EXEC)
+        return 0;
+    struct deque *d = &(t->sdeque[exec->num]);
+    struct deque_array *a = atomic_load(&(d->array));
+    long bottom = atomic_load(&(d->bottom));
+    int misplaced = 0;
+    for (long i=atomic_load(&(d->top)); i<bottom; i++) {
+        task_t *task = (task_t *)atomic_load(&(a->buffer[i % a->size]));
+        int level = task->level;
+        if (level > 0 && atomic_load(&(d->top)) <= i)
+            misplaced++;
+    }
+    return misplaced;
+}
+
+void napping_task(context_t ctx)
+{
+    (void)ctx;
+    for (int i=0; i<HEAVY_ROUNDS; i++) {
+        uint64_t until = timer_now() + HEAVY_SLICE_MS * 1000000;
+        while (timer_now() < until)
+            ; // burn CPU
+        task_sleep(NAP_MS * 1000000);
+        int misplaced = count_misplaced(tboard);
+        if (misplaced > 0) {
+            pthread_mutex_lock(&count_mutex);
+            misplaced_count += misplaced;
+            pthread_mutex_unlock(&count_mutex);
+        }
+    }
+    increment_count(&napping_count);
+}
+
+void short_task(context_t ctx)
+{
+    (void)ctx;
+    uint64_t issued = *((uint64_t *)task_get_args());
+    task_yield();
+    task_yield();
+    uint64_t latency = timer_now() - issued;
+    pthread_mutex_lock(&count_mutex);
+    short_count++;
+    latency_total += latency;
+    if (latency > latency_max)
+        latency_max = latency;
+    pthread_mutex_unlock(&count_mutex);
+}
+
+
+#endif
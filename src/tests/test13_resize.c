@@ -0,0 +1,154 @@
+/**
+ * Test 13: Dynamic executor pool. In this test, the task board starts with a single sExecutor
+ * and an autoscaler, and load arrives in waves separated by quiet periods
+ *
+ * load thread - Issues WAVES waves of WAVE_TASKS CPU-heavy secondary tasks. Between waves, it
+ *               waits for the wave to complete and stays quiet for QUIET_MS, recording how many
+ *               sExecutors are running at the peak of each wave and at the end of each quiet period
+ * heavy_task() - Burns HEAVY_SLICE_MS of CPU time between yields, HEAVY_ROUNDS times
+ *
+ * During the last wave, sExecutors are also added and retired by hand while tasks are queued.
+ * Every task should complete, wherever it was queued when its sExecutor retired.
+ */
+#include "tests.h"
+#ifdef TEST_13
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCALE_MIN 1
+#define SCALE_MAX (SECONDARY_EXECUTORS * 4)
+#define WAVES 2
+#define WAVE_TASKS NUM_TASKS
+#define HEAVY_ROUNDS 20
+#define HEAVY_SLICE_MS 1
+#define QUIET_MS (AUTOSCALE_INTERVAL * (AUTOSCALE_QUIET_PERIODS + 5))
+#define MANUAL_RESIZES 20
+
+int completion_count = 0;
+int peak[WAVES] = {0}, settled[WAVES] = {0};
+int manual_adds = 0, manual_removes = 0;
+bool waves_complete = false;
+
+clock_t test_time, kill_time;
+pthread_t loader;
+
+void heavy_task(context_t ctx);
+void *load_thread(void *args);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\t%d/%d tasks completed, %d sExecutors added and %d retired by hand.\n",
+        completion_count, WAVES * WAVE_TASKS, manual_adds, manual_removes);
+    for (int w=0; w<WAVES; w++)
+        printf("\tWave %d: %d sExecutors at peak, %d after %d ms quiet.\n", w, peak[w], settled[w], QUIET_MS);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SCALE_MIN);
+    assert(tboard_set_autoscale(tboard, SCALE_MIN, SCALE_MAX));
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&loader, NULL, load_thread, tboard);
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(loader, NULL);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *load_thread(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    for (int w=0; w<WAVES; w++) {
+        for (int i=0; i<WAVE_TASKS; i++)
+            task_create(t, TBOARD_FUNC(heavy_task), SECONDARY_EXEC, NULL, 0);
+        int resizes = 0;
+        while (read_count(&completion_count) < (w + 1) * WAVE_TASKS) {
+            if (atomic_load(&(t->sqs)) > peak[w])
+                peak[w] = atomic_load(&(t->sqs));
+            if (w == WAVES - 1 && resizes < MANUAL_RESIZES) { // retire and add while tasks are queued
+                if (resizes++ % 2 == 0) {
+                    if (tboard_remove_secondary(t))
+                        manual_removes++;
+                } else if (tboard_add_secondary(t) >= 0) {
+                    manual_adds++;
+                }
+            }
+            fsleep(0.01);
+        }
+        struct timespec quiet = {.tv_sec = QUIET_MS / 1000, .tv_nsec = (QUIET_MS % 1000) * 1000000L};
+        nanosleep(&quiet, NULL); // fsleep() sleeps for a random time
+        settled[w] = atomic_load(&(t->sqs));
+    }
+    waves_complete = true;
+    return NULL;
+}
+
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all waves completed, we kill task board
+        if (waves_complete) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+void heavy_task(context_t ctx)
+{
+    (void)ctx;
+    for (int i=0; i<HEAVY_ROUNDS; i++) {
+        uint64_t until = timer_now() + HEAVY_SLICE_MS * 1000000;
+        while (timer_now() < until)
+            ; // burn CPU
+        task_yield();
+    }
+    increment_count(&completion_count);
+}
+
+
+#endif
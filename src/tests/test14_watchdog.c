@@ -0,0 +1,144 @@
+/**
+ * Test 14: Runaway task watchdog. In this test, RUNAWAY_TASKS secondary tasks run far longer than
+ * the slice budget without yielding, while many well-behaved secondary tasks keep arriving
+ *
+ * runaway_task() - Burns RUNAWAY_MS of CPU time without yielding
+ * polite_task() - Yields POLITE_YIELDS times, then records the time since it was created
+ *
+ * Each runaway task should be flagged by the watchdog and show up in history with an overrun.
+ * With QUARANTINE set, polite tasks should not queue up behind runaway tasks.
+ */
+#include "tests.h"
+#ifdef TEST_14
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define QUARANTINE true
+#define SLICE_BUDGET_MS 5
+#define RUNAWAY_TASKS 1
+#define RUNAWAY_MS 100
+#define POLITE_TASKS (NUM_TASKS * 5)
+#define POLITE_YIELDS 5
+
+int completion_count = 0;
+int polite_count = 0;
+uint64_t latency_total = 0, latency_max = 0;
+
+clock_t test_time, kill_time;
+
+void runaway_task(context_t ctx);
+void polite_task(context_t ctx);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    for (int i=0; i<RUNAWAY_TASKS; i++)
+        task_create(tboard, TBOARD_FUNC(runaway_task), SECONDARY_EXEC, NULL, 0);
+    for (int i=0; i<POLITE_TASKS; i++) {
+        uint64_t *created = malloc(sizeof(uint64_t)); // free'd when polite_task() terminates
+        *created = timer_now();
+        if (!task_create(tboard, TBOARD_FUNC(polite_task), SECONDARY_EXEC, created, sizeof(uint64_t)))
+            free(created);
+        if (i % NUM_TASKS == 0)
+            fsleep(0.01);
+    }
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\tQuarantine %s. %d/%d tasks completed, %ld slices flagged.\n", QUARANTINE ? "enabled" : "disabled",
+        completion_count, RUNAWAY_TASKS + POLITE_TASKS, atomic_load(&(tboard->slice_overruns)));
+    printf("\tPolite task latency: %.3f ms on average, %.3f ms at most.\n",
+        (polite_count > 0) ? latency_total / 1e6 / polite_count : 0.0, latency_max / 1e6);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    assert(tboard_set_watchdog(tboard, (uint64_t)SLICE_BUDGET_MS * 1000000, QUARANTINE));
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all tasks completed, we kill task board
+        if (read_count(&completion_count) >= RUNAWAY_TASKS + POLITE_TASKS) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+void runaway_task(context_t ctx)
+{
+    (void)ctx;
+    uint64_t until = timer_now() + (uint64_t)RUNAWAY_MS * 1000000;
+    while (timer_now() < until)
+        ; // burn CPU without ever yielding
+    increment_count(&completion_count);
+}
+
+void polite_task(context_t ctx)
+{
+    (void)ctx;
+    uint64_t created = *((uint64_t *)task_get_args());
+    for (int i=0; i<POLITE_YIELDS; i++)
+        task_yield();
+    uint64_t latency = timer_now() - created;
+    pthread_mutex_lock(&count_mutex);
+    polite_count++;
+    latency_total += latency;
+    if (latency > latency_max)
+        latency_max = latency;
+    pthread_mutex_unlock(&count_mutex);
+    increment_count(&completion_count);
+}
+
+
+#endif
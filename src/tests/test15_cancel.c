@@ -0,0 +1,193 @@
+/**
+ * Test 15: Task cancellation. In this test, tasks are cancelled by ID while they wait in ready
+ * queues and in the timer wheel
+ *
+ * yield_task() - Yields YIELDS times, then records that it completed
+ * sleep_task() - Sleeps SLEEP_MS, then records that it completed
+ * long_sleep_task() - Sleeps LONG_SLEEP_S, and is always cancelled while it sleeps
+ *
+ * Every CANCEL_EVERY-th task of each kind is cancelled right after it is created, sleeping tasks
+ * by the uuid string their ID maps to, as a controller would. Cancelled tasks
+ * should not complete, unless cancelled during their last slice (counted as late), and every
+ * cancelled task should be released so the task board drains to no concurrent tasks.
+ * Long sleepers are cancelled once all of them are asleep, and must be released right away,
+ * which the concurrent task count shows.
+ */
+#include "tests.h"
+#ifdef TEST_15
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define YIELD_TASKS (NUM_TASKS * 10)
+#define SLEEP_TASKS NUM_TASKS
+#define YIELDS 20
+#define SLEEP_MS 50
+#define CANCEL_EVERY 2
+#define LONG_SLEEPERS (NUM_TASKS / 10)
+#define LONG_SLEEP_S 3600
+
+int completion_count = 0;
+int late_count = 0;
+int cancel_count = 0;
+int asleep_count = 0;
+int concurrent_before = 0, concurrent_after = 0;
+bool issued_all = false;
+bool cancelled[YIELD_TASKS + SLEEP_TASKS] = {0};
+int index_of[YIELD_TASKS + SLEEP_TASKS];
+
+clock_t test_time, kill_time;
+
+void yield_task(context_t ctx);
+void sleep_task(context_t ctx);
+void long_sleep_task(context_t ctx);
+static void task_done(int k);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    // long sleepers must not hold on to their slots until they would have woken
+    uint64_t long_ids[LONG_SLEEPERS];
+    for (int i=0; i<LONG_SLEEPERS; i++) {
+        long_ids[i] = task_create_id(tboard, TBOARD_FUNC(long_sleep_task), SECONDARY_EXEC, NULL, 0);
+        assert(long_ids[i] != 0);
+    }
+    while (read_count(&asleep_count) < LONG_SLEEPERS)
+        fsleep(0.001);
+    fsleep(0.01); // let executors put the last of them in the timer wheel
+    concurrent_before = tboard_get_concurrent(tboard);
+    for (int i=0; i<LONG_SLEEPERS; i++) {
+        bool res = task_cancel(tboard, long_ids[i]);
+        assert(res);
+    }
+    concurrent_after = tboard_get_concurrent(tboard);
+    assert(concurrent_after <= concurrent_before - LONG_SLEEPERS);
+
+    for (int k=0; k<YIELD_TASKS + SLEEP_TASKS; k++) {
+        index_of[k] = k;
+        bool sleeper = (k >= YIELD_TASKS);
+        uint64_t id = task_create_id(tboard, sleeper ? TBOARD_FUNC(sleep_task) : TBOARD_FUNC(yield_task),
+                                     SECONDARY_EXEC, &(index_of[k]), 0);
+        assert(id != 0);
+        if (k % CANCEL_EVERY == 0) {
+            pthread_mutex_lock(&count_mutex);
+            cancelled[k] = true; // before cancelling, task may complete meanwhile
+            pthread_mutex_unlock(&count_mutex);
+            if (sleeper) { // cancel through the wire form of the ID
+                char uuid[UUID4_LEN];
+                task_id_to_uuid(tboard, id, uuid);
+                id = task_id_from_uuid(tboard, uuid);
+            }
+            if (task_cancel(tboard, id))
+                increment_count(&cancel_count);
+            assert(!task_cancel(tboard, id)); // cancelled or terminated already
+        }
+    }
+    issued_all = true;
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\t%d tasks created, %d cancelled. %d completed, %d of which completed although cancelled.\n",
+        YIELD_TASKS + SLEEP_TASKS, cancel_count, completion_count, late_count);
+    printf("\tCancelling %d long sleepers took concurrent tasks from %d to %d.\n",
+        LONG_SLEEPERS, concurrent_before, concurrent_after);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // once every task has completed or been discarded, we kill task board
+        if (issued_all && tboard_get_concurrent(t) == 0) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+static void task_done(int k)
+{
+    pthread_mutex_lock(&count_mutex);
+    completion_count++;
+    if (cancelled[k])
+        late_count++;
+    pthread_mutex_unlock(&count_mutex);
+}
+
+void yield_task(context_t ctx)
+{
+    (void)ctx;
+    int k = *((int *)task_get_args());
+    for (int i=0; i<YIELDS; i++)
+        task_yield();
+    task_done(k);
+}
+
+void sleep_task(context_t ctx)
+{
+    (void)ctx;
+    int k = *((int *)task_get_args());
+    task_sleep((uint64_t)SLEEP_MS * 1000000);
+    task_done(k);
+}
+
+void long_sleep_task(context_t ctx)
+{
+    (void)ctx;
+    increment_count(&asleep_count);
+    task_sleep((uint64_t)LONG_SLEEP_S * 1000000000ULL);
+    increment_count(&completion_count); // never, cancelled while asleep
+}
+
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * Test 16: Stack size classes. In this test, tasks of a function that barely uses its stack run
+ * alongside tasks of a function that recurses through large stack frames
+ *
+ * shallow_task() - Yields SHALLOW_YIELDS times
+ * deep_task() - Recurses DEEP_DEPTH frames of FRAME_BYTES each, yielding at the deepest frame
+ * digging_task() - Barely uses its stack while probed, then digs into the guard of the first
+ *                  downsized stack it gets, as a function whose depth depends on input would
+ *
+ * Stack sizing is enabled. After the first STACK_PROBE_RUNS runs of each function have been
+ * probed, shallow tasks should run on the smallest stack class and deep tasks on a larger one,
+ * which history and pool statistics show. Every task should complete, and checksums of deep
+ * tasks should match. Digging tasks run one at a time, and once one has touched its guard,
+ * every later one should get a STACK_SIZE stack. With STACK_PROFILE set, stack usage of every
+ * task is profiled too.
+ */
+#include "tests.h"
+#ifdef TEST_16
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SHALLOW_TASKS (NUM_TASKS * 10)
+#define DEEP_TASKS (NUM_TASKS * 2)
+#define SHALLOW_YIELDS 5
+#define DEEP_DEPTH 12
+#define FRAME_BYTES 1024
+#define STACK_PROFILE true
+#define DIGGING_TASKS (STACK_PROBE_RUNS + 4)
+#define DIG_FRAME_BYTES 64
+
+int completion_count = 0;
+int checksum_errors = 0;
+int digging_count = 0;
+int dug = 0; // digging tasks that touched their guard
+int downsized_after_dig = 0; // digging tasks that still got a downsized stack after that
+
+clock_t test_time, kill_time;
+
+void shallow_task(context_t ctx);
+void deep_task(context_t ctx);
+void digging_task(context_t ctx);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    // one at a time, so each sees the stack size class left by the one before
+    for (int i=0; i<DIGGING_TASKS; i++) {
+        task_create(tboard, TBOARD_FUNC(digging_task), SECONDARY_EXEC, NULL, 0);
+        while (read_count(&digging_count) <= i)
+            fsleep(0.001);
+        fsleep(0.01); // executor checks guard once task has returned
+    }
+
+    for (int i=0; i<SHALLOW_TASKS + DEEP_TASKS; i++) {
+        if (i % ((SHALLOW_TASKS + DEEP_TASKS) / DEEP_TASKS) == 0)
+            task_create(tboard, TBOARD_FUNC(deep_task), SECONDARY_EXEC, NULL, 0);
+        else
+            task_create(tboard, TBOARD_FUNC(shallow_task), SECONDARY_EXEC, NULL, 0);
+        if (i % NUM_TASKS == 0)
+            fsleep(0.01);
+    }
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\t%d/%d tasks completed, %d deep task checksums did not match.\n",
+        completion_count, SHALLOW_TASKS + DEEP_TASKS, checksum_errors);
+    printf("\t%d/%d digging tasks completed, %d touched their guard, %d were downsized after that.\n",
+        digging_count, DIGGING_TASKS, dug, downsized_after_dig);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+    assert(dug == 1 && downsized_after_dig == 0);
+
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    tboard_set_stack_profile(tboard, STACK_PROFILE);
+    tboard_set_stack_sizing(tboard, true);
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all tasks completed, we kill task board
+        if (read_count(&completion_count) >= SHALLOW_TASKS + DEEP_TASKS) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            printf("=================== POOL STATISTICS ================\n");
+            pool_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+static int recurse(int depth)
+{
+    volatile char frame[FRAME_BYTES]; // volatile so frame is not optimized away
+    for (int i=0; i<FRAME_BYTES; i++)
+        frame[i] = (char)(depth + i);
+    int sum = (depth == 0) ? 0 : recurse(depth - 1);
+    if (depth == 0)
+        task_yield(); // yield with the deepest stack in use
+    for (int i=0; i<FRAME_BYTES; i++)
+        sum += frame[i];
+    return sum;
+}
+
+void shallow_task(context_t ctx)
+{
+    (void)ctx;
+    for (int i=0; i<SHALLOW_YIELDS; i++)
+        task_yield();
+    increment_count(&completion_count);
+}
+
+void deep_task(context_t ctx)
+{
+    (void)ctx;
+    int expected = 0;
+    for (int d=0; d<=DEEP_DEPTH; d++) {
+        for (int i=0; i<FRAME_BYTES; i++)
+            expected += (char)(d + i);
+    }
+    if (recurse(DEEP_DEPTH) != expected) {
+        pthread_mutex_lock(&count_mutex);
+        checksum_errors++;
+        pthread_mutex_unlock(&count_mutex);
+    }
+    increment_count(&completion_count);
+}
+
+static int dig(const char *stack_base)
+{
+    // stop once this frame is inside the guard, with room left for the calls below
+    volatile char frame[DIG_FRAME_BYTES];
+    for (int i=0; i<DIG_FRAME_BYTES; i++)
+        frame[i] = (char)i;
+    int sum = ((const char *)frame - stack_base > STACK_GUARD / 2) ? dig(stack_base) : 0;
+    return sum + frame[0];
+}
+
+void digging_task(context_t ctx)
+{
+    size_t stack_size = ctx->stack_size;
+    if (stack_size < STACK_SIZE) {
+        pthread_mutex_lock(&count_mutex);
+        bool first = (dug == 0);
+        if (first)
+            dug++;
+        else
+            downsized_after_dig++;
+        pthread_mutex_unlock(&count_mutex);
+        if (first)
+            dig((const char *)ctx->stack_base);
+    }
+    increment_count(&digging_count);
+}
+
+
+#endif
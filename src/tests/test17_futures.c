@@ -0,0 +1,196 @@
+/**
+ * Test 17: Fan-out/fan-in futures. In this test, parent tasks split a range of Collatz starting
+ * values into subproblems, spawn a child task per subproblem and join them all
+ *
+ * parent_task() - Spawns FANOUT children with task_spawn() over its range, joins them with
+ *                 task_join_all() and checks the longest sequence found against a sequential count
+ * collatz_task() - Finds the longest Collatz sequence among its starting values, yielding
+ *                  every YIELD_EVERY values, and writes it to its arguments
+ * quick_task() - Terminates right away, so it is usually done before it is joined
+ *
+ * Parents should be parked while they wait instead of taking executor time, so every parent
+ * should complete and every result should match.
+ */
+#include "tests.h"
+#ifdef TEST_17
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PARENTS (NUM_TASKS / 10)
+#define FANOUT 16
+#define RANGE_PER_CHILD 2000
+#define YIELD_EVERY 250
+
+struct collatz_range {
+    uint64_t start;
+    uint64_t end;
+    int longest; // written by collatz_task()
+};
+
+int completion_count = 0;
+int mismatch_count = 0;
+int join_failures = 0;
+int children_spawned = 0;
+
+clock_t test_time, kill_time;
+
+void parent_task(context_t ctx);
+void collatz_task(context_t ctx);
+void quick_task(context_t ctx);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    for (int i=0; i<PARENTS; i++) {
+        // primary and secondary parents, children are always secondary
+        task_create_copy(tboard, TBOARD_FUNC(parent_task), (i % 2 == 0) ? PRIMARY_EXEC : SECONDARY_EXEC,
+                         &i, sizeof(int));
+    }
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\t%d/%d parent tasks completed, %d children spawned. %d results did not match, %d joins failed.\n",
+        completion_count, PARENTS, children_spawned, mismatch_count, join_failures);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all parents completed, we kill task board
+        if (read_count(&completion_count) >= PARENTS) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+static int collatz_length(uint64_t x)
+{
+    int n = 1;
+    while (x != 1) {
+        x = (x % 2 == 0) ? x / 2 : 3 * x + 1;
+        n++;
+    }
+    return n;
+}
+
+void parent_task(context_t ctx)
+{
+    (void)ctx;
+    int k = *((int *)task_get_args());
+    uint64_t base = 1 + (uint64_t)k * FANOUT * RANGE_PER_CHILD;
+
+    // fan out, children write their results into ranges we own
+    struct collatz_range ranges[FANOUT];
+    task_future_t *futures[FANOUT + 1];
+    for (int i=0; i<FANOUT; i++) {
+        ranges[i].start = base + (uint64_t)i * RANGE_PER_CHILD;
+        ranges[i].end = ranges[i].start + RANGE_PER_CHILD;
+        ranges[i].longest = 0;
+        futures[i] = task_spawn(tboard, TBOARD_FUNC(collatz_task), SECONDARY_EXEC, &(ranges[i]), 0);
+    }
+    futures[FANOUT] = task_spawn(tboard, TBOARD_FUNC(quick_task), SECONDARY_EXEC, NULL, 0);
+    // let quick child terminate before it is joined
+    for (int i=0; i<5; i++)
+        task_yield();
+
+    // fan in
+    bool joined = task_join_all(futures, FANOUT + 1);
+    int longest = 0;
+    for (int i=0; i<FANOUT; i++) {
+        if (ranges[i].longest > longest)
+            longest = ranges[i].longest;
+    }
+
+    // check against a sequential count
+    int expected = 0;
+    for (uint64_t x=base; x<base + (uint64_t)FANOUT * RANGE_PER_CHILD; x++) {
+        int n = collatz_length(x);
+        if (n > expected)
+            expected = n;
+    }
+
+    pthread_mutex_lock(&count_mutex);
+    children_spawned += FANOUT + 1;
+    if (!joined)
+        join_failures++;
+    if (longest != expected)
+        mismatch_count++;
+    completion_count++;
+    pthread_mutex_unlock(&count_mutex);
+}
+
+void collatz_task(context_t ctx)
+{
+    (void)ctx;
+    struct collatz_range *range = (struct collatz_range *)task_get_args();
+    int longest = 0;
+    for (uint64_t x=range->start; x<range->end; x++) {
+        int n = collatz_length(x);
+        if (n > longest)
+            longest = n;
+        if ((x - range->start) % YIELD_EVERY == YIELD_EVERY - 1)
+            task_yield();
+    }
+    range->longest = longest;
+}
+
+void quick_task(context_t ctx)
+{
+    (void)ctx;
+}
+
+
+#endif
@@ -0,0 +1,169 @@
+/**
+ * Test 18: Parallel loops. In this test, a large array is filled with tboard_parallel_for() and
+ * summed with tboard_parallel_reduce(), ROUNDS times, from a primary task and from the main thread
+ *
+ * fill_range() - Writes the Collatz sequence length of every element to the array
+ * sum_range() - Adds array elements to a running sum
+ * loop_task() - Fills and sums the array from a task, which is parked while the ranges run
+ *
+ * Grain sizes are adapted from history, so later rounds should split the range into a handful
+ * of tasks per sExecutor rather than one per element. Every sum should match a sequential sum.
+ */
+#include "tests.h"
+#ifdef TEST_18
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ELEMENTS (NUM_TASKS * 2000)
+#define ROUNDS 4
+
+int *values;
+int64_t expected = 0;
+int completion_count = 0;
+int mismatch_count = 0;
+int failure_count = 0;
+
+clock_t test_time, kill_time;
+
+void fill_range(int64_t begin, int64_t end, void *ctx);
+void sum_range(int64_t begin, int64_t end, void *ctx, void *acc);
+void add_sums(void *acc, const void *other, void *ctx);
+void loop_task(context_t ctx);
+static void run_round(const char *caller);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    values = calloc(ELEMENTS, sizeof(int));
+    for (int64_t x=0; x<ELEMENTS; x++) {
+        int n = 1;
+        for (uint64_t c=x+1; c!=1; c=(c % 2 == 0) ? c / 2 : 3 * c + 1)
+            n++;
+        expected += n;
+    }
+    init_tests();
+
+    // half of the rounds from a task, the other half from main thread
+    task_create(tboard, TBOARD_FUNC(loop_task), PRIMARY_EXEC, NULL, 0);
+    for (int r=0; r<ROUNDS / 2; r++)
+        run_round("main thread");
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\t%d/%d rounds completed, %d sums did not match, %d loops failed.\n",
+        completion_count, ROUNDS, mismatch_count, failure_count);
+    printf("Test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        test_time, kill_time);
+    assert(mismatch_count == 0 && failure_count == 0);
+
+    free(values);
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all rounds completed, we kill task board
+        if (read_count(&completion_count) >= ROUNDS) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+static void run_round(const char *caller)
+{
+    int64_t sum = 0;
+    bool ok = tboard_parallel_for(tboard, 0, ELEMENTS, 0, TBOARD_RANGE(fill_range), values);
+    ok = ok && tboard_parallel_reduce(tboard, 0, ELEMENTS, 0, TBOARD_REDUCE(sum_range), add_sums,
+                                      values, &sum, sizeof(int64_t));
+    printf("Round from %s: sum %ld, expected %ld.\n", caller, (long)sum, (long)expected);
+    pthread_mutex_lock(&count_mutex);
+    if (!ok)
+        failure_count++;
+    else if (sum != expected)
+        mismatch_count++;
+    pthread_mutex_unlock(&count_mutex);
+    increment_count(&completion_count);
+}
+
+
+//////////////// Task Functions ///////////////
+void fill_range(int64_t begin, int64_t end, void *ctx)
+{
+    int *v = (int *)ctx;
+    for (int64_t x=begin; x<end; x++) {
+        int n = 1;
+        for (uint64_t c=x+1; c!=1; c=(c % 2 == 0) ? c / 2 : 3 * c + 1)
+            n++;
+        v[x] = n;
+    }
+}
+
+void sum_range(int64_t begin, int64_t end, void *ctx, void *acc)
+{
+    const int *v = (const int *)ctx;
+    int64_t *sum = (int64_t *)acc;
+    for (int64_t x=begin; x<end; x++)
+        *sum += v[x];
+}
+
+void add_sums(void *acc, const void *other, void *ctx)
+{
+    (void)ctx;
+    *((int64_t *)acc) += *((const int64_t *)other);
+}
+
+void loop_task(context_t ctx)
+{
+    (void)ctx;
+    for (int r=0; r<ROUNDS - ROUNDS / 2; r++)
+        run_round("primary task");
+}
+
+
+#endif
@@ -82,6 +82,8 @@ void *check_completion(void *args)
             kill_time = clock() - kill_time;
             printf("=================== TASK STATISTICS ================\n");
             history_print_records(t, stdout);
+            printf("=================== POOL STATISTICS ================\n");
+            pool_print_stats(t, stdout);
             pthread_mutex_unlock(&(t->tmutex));
             break;
         } else { // tasks havent completed, sleep for a bit
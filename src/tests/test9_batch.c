@@ -0,0 +1,145 @@
+/**
+ * Test 9: Batch task submission. In this test, a spawning task fans out a large number of
+ * secondary tasks using task_create_batch() instead of one task_create() call per task
+ * 
+ * spawning_task() - Spawns BATCH_TASKS secondary sub tasks, BATCH_SIZE at a time, and then exits
+ * sub_task() - Rapidly tests collatz conjecture and yields, one at a time
+ * 
+ * Arguments are passed as intptr_t as in test 2 (noalloc), so sizeof_args is 0
+ */
+#include "tests.h"
+#ifdef TEST_9
+
+#include "../tboard.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BATCH_TASKS (NUM_TASKS * 100)
+#define BATCH_SIZE 256
+
+int completion_count = 0;
+int task_count = 0;
+bool spawning_task_complete = false;
+
+clock_t test_time, kill_time, spawn_time;
+
+void sub_task(context_t ctx);
+void spawning_task(context_t ctx);
+
+int main()
+{
+    // init test
+    test_time = clock();
+    init_tests();
+
+    // create spawning task
+    task_create(tboard, TBOARD_FUNC(spawning_task), PRIMARY_EXEC, NULL, 0);
+
+    destroy_tests();
+    test_time = clock() - test_time;
+
+    printf("\n=================== TEST STATISTICS ================\n");
+    printf("\t%d/%d sub tasks completed, %d were created in batches of %d.\n", completion_count, BATCH_TASKS, task_count, BATCH_SIZE);
+    printf("Spawning took %ld CPU cycles, test took %ld CPU cycles to complete, killing taskboard took %ld CPU cycles to complete.\n",
+        spawn_time, test_time, kill_time);
+    
+    tboard_exit();
+    return 0;
+
+}
+
+void init_tests()
+{
+    tboard = tboard_create(SECONDARY_EXECUTORS);
+    pthread_mutex_init(&count_mutex, NULL);
+
+    tboard_start(tboard);
+
+    pthread_create(&chk_complete, NULL, check_completion, tboard);
+
+    printf("Taskboard created, all threads initialized.\n");
+}
+
+void destroy_tests()
+{
+    tboard_destroy(tboard);
+    pthread_join(chk_complete, NULL);
+    pthread_mutex_destroy(&count_mutex);
+}
+
+/////////////// Thread Functions //////////////////////
+void *check_completion(void *args)
+{
+    tboard_t *t = (tboard_t *)args;
+    while (true) {
+        // if all tasks completed, we kill task board
+        if (spawning_task_complete && read_count(&completion_count) >= task_count) {
+            pthread_mutex_lock(&(t->tmutex));
+            kill_time = clock();
+            tboard_kill(t);
+            kill_time = clock() - kill_time;
+            printf("=================== TASK STATISTICS ================\n");
+            history_print_records(t, stdout);
+            printf("=================== POOL STATISTICS ================\n");
+            pool_print_stats(t, stdout);
+            printf("=================== EXECUTOR STATISTICS ============\n");
+            executor_print_stats(t, stdout);
+            pthread_mutex_unlock(&(t->tmutex));
+            break;
+        } else { // tasks havent completed, sleep for a bit
+            fsleep(0.01);
+        }
+    }
+    return NULL;
+}
+
+
+//////////////// Task Functions ///////////////
+void sub_task(context_t ctx)
+{
+    // check collatz, yielding at every iteration
+    (void)ctx;
+    long x = (intptr_t)task_get_args();
+    while (x > 1) {
+        if (x % 2 == 0) x /= 2;
+        else            x = 3*x + 1;
+        task_yield();
+    }
+    increment_count(&completion_count);
+}
+
+void spawning_task(context_t ctx)
+{
+    (void)ctx;
+    void *args[BATCH_SIZE];
+    int attempt = 0;
+    spawn_time = clock();
+    for (long i=0; i<BATCH_TASKS; ) {
+        int n = (BATCH_TASKS - i < BATCH_SIZE) ? BATCH_TASKS - i : BATCH_SIZE;
+        for (int k=0; k<n; k++)
+            args[k] = (void *)(intptr_t)(i + k);
+        // fewer than n tasks are created once MAX_TASKS is reached, retry the rest after yielding
+        int created = task_create_batch(tboard, TBOARD_FUNC(sub_task), SECONDARY_EXEC, args, 0, n);
+        task_count += created;
+        i += created;
+        if (created < n) {
+            if (attempt++ > MAX_TASK_ATTEMPT) {
+                tboard_err("spawning_task: Unable to create sub tasks at iteration %ld after %d attempts.\n", i, MAX_TASK_ATTEMPT);
+                break;
+            }
+            task_yield();
+        } else {
+            attempt = 0;
+        }
+    }
+    spawn_time = clock() - spawn_time;
+    spawning_task_complete = true;
+}
+
+
+#endif
@@ -42,6 +42,26 @@
         #define TEST_7
     #elif TEST_NUM == 8
         #define TEST_8
+    #elif TEST_NUM == 9
+        #define TEST_9
+    #elif TEST_NUM == 10
+        #define TEST_10
+    #elif TEST_NUM == 11
+        #define TEST_11
+    #elif TEST_NUM == 12
+        #define TEST_12
+    #elif TEST_NUM == 13
+        #define TEST_13
+    #elif TEST_NUM == 14
+        #define TEST_14
+    #elif TEST_NUM == 15
+        #define TEST_15
+    #elif TEST_NUM == 16
+        #define TEST_16
+    #elif TEST_NUM == 17
+        #define TEST_17
+    #elif TEST_NUM == 18
+        #define TEST_18
     #endif
 #endif
 
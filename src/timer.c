@@ -1,8 +1,232 @@
 /**
  * Contains all functions pertaining to the task board timer
- * 
- * Since this is not yet implemented into the task board in milestone 1-2,
- * this file is empty.
+ *
+ * Tasks that call task_sleep() or task_yield_until() are taken off the ready queues and kept
+ * in a hierarchical timer wheel until they expire, at which point they are returned to a
+ * ready queue via task_place(). The wheel has TIMER_LEVELS levels of TIMER_SLOTS slots. A
+ * slot of level 0 spans one tick of TIMER_RESOLUTION ns, and a slot of level l spans a whole
+ * rotation of level l-1. A sleeping task sits in the lowest level whose rotation reaches its
+ * expiry, and moves down a level (cascades) each time the wheel enters the span of its slot,
+ * so inserting and expiring is O(1) regardless of the number of sleeping tasks.
+ *
+ * Slots are doubly linked lists, so a cancelled task is unlinked from its slot right away (see
+ * timer_remove()) instead of holding on to its resources until it would have woken.
+ *
+ * The wheel is protected by @t->timer_mutex. Every executor advances the wheel at the start
+ * of each iteration if a tick has passed, but only if the lock is free, so executors never
+ * wait on each other for it. Ticks at which no slot expires or cascades are skipped in one step
+ * (see timer_next_due()), so catching up after a stall costs a scan of the slots, not a walk of
+ * every missed tick. pExecutor also bounds how long it parks by the next expiry (see
+ * timer_wait()), so sleeping tasks are woken even if every executor is idle.
  */
 #include "tboard.h"
-#include "timer.h"
\ No newline at end of file
+#include "timer.h"
+
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define TIMER_SLOT_MASK (TIMER_SLOTS - 1)
+
+
+uint64_t timer_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+void timer_init(tboard_t *t)
+{
+    assert(pthread_mutex_init(&(t->timer_mutex), NULL) == 0);
+    for (int l=0; l<TIMER_LEVELS; l++) {
+        for (int s=0; s<TIMER_SLOTS; s++)
+            TAILQ_INIT(&(t->timer_wheel[l][s]));
+    }
+    atomic_init(&(t->timer_tick), timer_now() / TIMER_RESOLUTION);
+    atomic_init(&(t->timer_count), 0);
+    t->timer_next = UINT64_MAX;
+}
+
+void timer_destroy(tboard_t *t)
+{
+    // executors are joined, so sleeping tasks are referenced by nothing but the wheel
+    for (int l=0; l<TIMER_LEVELS; l++) {
+        for (int s=0; s<TIMER_SLOTS; s++) {
+            task_t *task;
+            while ((task = TAILQ_FIRST(&(t->timer_wheel[l][s]))) != NULL) {
+                TAILQ_REMOVE(&(t->timer_wheel[l][s]), task, timer_link);
+                task_destroy(task);
+            }
+        }
+    }
+    atomic_store(&(t->timer_count), 0);
+    pthread_mutex_destroy(&(t->timer_mutex));
+}
+
+static void timer_insert(tboard_t *t, task_t *task, uint64_t base)
+{
+    // @base is the last tick the wheel has processed. Level l holds tasks whose slot at that
+    // level is entered within TIMER_SLOTS slots after @base. Round up so we never wake a task early
+    uint64_t expires = (task->wake_at + TIMER_RESOLUTION - 1) / TIMER_RESOLUTION;
+    if (expires <= base)
+        expires = base + 1;
+    int l = 0;
+    while (l < TIMER_LEVELS - 1 && (expires >> (TIMER_SLOT_BITS * l)) - (base >> (TIMER_SLOT_BITS * l)) > TIMER_SLOTS)
+        l++;
+    uint64_t span = expires >> (TIMER_SLOT_BITS * l);
+    uint64_t last = (base >> (TIMER_SLOT_BITS * l)) + TIMER_SLOTS;
+    if (span > last) // beyond reach of the wheel, park in its last slot and cascade from there
+        span = last;
+    task->timer_slot = &(t->timer_wheel[l][span & TIMER_SLOT_MASK]);
+    TAILQ_INSERT_TAIL(task->timer_slot, task, timer_link);
+}
+
+static uint64_t timer_next_due(tboard_t *t, uint64_t tick, uint64_t limit)
+{
+    // first tick after @tick that expires or cascades a slot, or @limit if it comes first. Level l
+    // holds no slot entered later than TIMER_SLOTS slots ahead, and slot k of level l is entered
+    // at tick k << (TIMER_SLOT_BITS * l), so higher levels are only scanned up to the best so far
+    uint64_t next = limit;
+    for (int l=0; l<TIMER_LEVELS; l++) {
+        uint64_t cur = tick >> (TIMER_SLOT_BITS * l);
+        for (uint64_t k=cur+1; k<=cur+TIMER_SLOTS && (k << (TIMER_SLOT_BITS * l)) < next; k++) {
+            if (!TAILQ_EMPTY(&(t->timer_wheel[l][k & TIMER_SLOT_MASK]))) {
+                next = k << (TIMER_SLOT_BITS * l);
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+bool timer_add(tboard_t *t, task_t *task, uint64_t wake_at)
+{
+    task->wake_at = wake_at;
+    if (wake_at <= timer_now())
+        return false; // already expired, caller places task right away
+
+    pthread_mutex_lock(&(t->timer_mutex));
+    // task_cancel() flags task before it looks for it in the wheel, under our lock
+    if (atomic_load_explicit(&(task->cancelled), memory_order_acquire)) {
+        pthread_mutex_unlock(&(t->timer_mutex));
+        return false; // caller places task, whose executor discards it
+    }
+    uint64_t tick = atomic_load_explicit(&(t->timer_tick), memory_order_relaxed);
+    if (atomic_load_explicit(&(t->timer_count), memory_order_relaxed) == 0) {
+        // timer_advance() leaves an empty wheel be, so it may be far behind after idling. Nothing
+        // is asleep, so move it to the current tick rather than inserting relative to a stale one
+        uint64_t now_tick = timer_now() / TIMER_RESOLUTION;
+        if (now_tick > tick) {
+            tick = now_tick;
+            atomic_store_explicit(&(t->timer_tick), tick, memory_order_relaxed);
+        }
+    }
+    timer_insert(t, task, tick);
+    atomic_fetch_add_explicit(&(t->timer_count), 1, memory_order_relaxed);
+    // pExecutor may be parked until a later expiry, wake it so it parks again with a shorter timeout
+    bool earlier = wake_at / TIMER_RESOLUTION < t->timer_next;
+    if (earlier)
+        t->timer_next = wake_at / TIMER_RESOLUTION;
+    pthread_mutex_unlock(&(t->timer_mutex));
+
+    if (earlier)
+        executor_wake_primary(t);
+    return true;
+}
+
+void timer_advance(tboard_t *t)
+{
+    if (atomic_load_explicit(&(t->timer_count), memory_order_relaxed) == 0)
+        return;
+    uint64_t now_tick = timer_now() / TIMER_RESOLUTION;
+    if (now_tick <= atomic_load_explicit(&(t->timer_tick), memory_order_relaxed))
+        return;
+    if (pthread_mutex_trylock(&(t->timer_mutex)) != 0)
+        return; // another executor is advancing the wheel
+
+    struct timer_slot due = TAILQ_HEAD_INITIALIZER(due);
+    int expired = 0;
+    uint64_t tick = atomic_load_explicit(&(t->timer_tick), memory_order_relaxed);
+    while (tick < now_tick && atomic_load_explicit(&(t->timer_count), memory_order_relaxed) > expired) {
+        // skip ticks whose slots are all empty in one step instead of walking them one at a time
+        uint64_t next = timer_next_due(t, tick, now_tick + 1);
+        if (next > now_tick)
+            break;
+        tick = next;
+        // entering the span of a higher level slot, cascade its tasks down, highest level first
+        // so tasks cascading through several levels at once end up in level 0. Slot of level 0
+        // for this tick is not processed yet, so they are inserted relative to the previous tick
+        int top = 0;
+        while (top < TIMER_LEVELS - 1 && ((tick >> (TIMER_SLOT_BITS * (top + 1))) << (TIMER_SLOT_BITS * (top + 1))) == tick)
+            top++;
+        for (int l=top; l>0; l--) {
+            struct timer_slot cascade = TAILQ_HEAD_INITIALIZER(cascade);
+            TAILQ_CONCAT(&cascade, &(t->timer_wheel[l][(tick >> (TIMER_SLOT_BITS * l)) & TIMER_SLOT_MASK]), timer_link);
+            task_t *task;
+            while ((task = TAILQ_FIRST(&cascade)) != NULL) {
+                TAILQ_REMOVE(&cascade, task, timer_link);
+                timer_insert(t, task, tick - 1);
+            }
+        }
+        struct timer_slot *slot = &(t->timer_wheel[0][tick & TIMER_SLOT_MASK]);
+        task_t *task;
+        while ((task = TAILQ_FIRST(slot)) != NULL) {
+            TAILQ_REMOVE(slot, task, timer_link);
+            task->timer_slot = NULL; // no longer asleep, task_cancel() leaves it to its executor
+            TAILQ_INSERT_TAIL(&due, task, timer_link);
+            expired++;
+        }
+    }
+    if (tick < now_tick) // nothing due before now, or no sleeping tasks left, catch up in one step
+        tick = now_tick;
+    atomic_store_explicit(&(t->timer_tick), tick, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&(t->timer_count), expired, memory_order_relaxed);
+    if (t->timer_next <= tick)
+        t->timer_next = UINT64_MAX; // recomputed by pExecutor in timer_wait()
+    pthread_mutex_unlock(&(t->timer_mutex));
+
+    // return expired tasks to ready queues outside of lock, task_place() may wake executors.
+    // Unlink each before placing it, it may be running and asleep again right after
+    task_t *task;
+    while ((task = TAILQ_FIRST(&due)) != NULL) {
+        TAILQ_REMOVE(&due, task, timer_link);
+        task_place(t, task);
+    }
+}
+
+bool timer_remove(tboard_t *t, task_t *task)
+{
+    pthread_mutex_lock(&(t->timer_mutex));
+    struct timer_slot *slot = task->timer_slot;
+    if (slot != NULL) {
+        TAILQ_REMOVE(slot, task, timer_link);
+        task->timer_slot = NULL;
+        atomic_fetch_sub_explicit(&(t->timer_count), 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&(t->timer_mutex));
+    return slot != NULL;
+}
+
+long timer_wait(tboard_t *t)
+{
+    if (atomic_load_explicit(&(t->timer_count), memory_order_relaxed) == 0)
+        return -1;
+    pthread_mutex_lock(&(t->timer_mutex));
+    uint64_t tick = atomic_load_explicit(&(t->timer_tick), memory_order_relaxed);
+    // next non-empty level 0 slot, or the next cascade if level 0 is empty. Waking up for a
+    // cascade that expires nothing is harmless
+    uint64_t next = ((tick >> TIMER_SLOT_BITS) + 1) << TIMER_SLOT_BITS;
+    for (uint64_t k=tick+1; k<next; k++) {
+        if (!TAILQ_EMPTY(&(t->timer_wheel[0][k & TIMER_SLOT_MASK]))) {
+            next = k;
+            break;
+        }
+    }
+    t->timer_next = next;
+    pthread_mutex_unlock(&(t->timer_mutex));
+
+    uint64_t now = timer_now();
+    return (next * TIMER_RESOLUTION > now) ? (long)(next * TIMER_RESOLUTION - now) : 0;
+}
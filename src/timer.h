@@ -1,7 +1,6 @@
 #ifndef __TIMER_H_
 #define __TIMER_H_
 /**
- * Since this is not yet implemented into the task board in milestone 1-2,
- * this file is empty.
+ * Timer wheel of task board, prototypes are found in tboard.h
  */
-#endif
\ No newline at end of file
+#endif